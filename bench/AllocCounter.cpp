@@ -0,0 +1,59 @@
+#include "AllocCounter.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<long> nAllocations(0);
+static std::atomic<long> nFrees(0);
+
+long allocationCount() {
+	return nAllocations.load(std::memory_order_relaxed);
+}
+
+long freeCount() {
+	return nFrees.load(std::memory_order_relaxed);
+}
+
+long liveAllocations() {
+	return allocationCount() - freeCount();
+}
+
+static void countedFree(void *p) {
+	if (p == NULL) return;
+	nFrees.fetch_add(1, std::memory_order_relaxed);
+	std::free(p);
+}
+
+//  Same as the standard operator new, plus a count
+//
+void *operator new(std::size_t size) {
+	nAllocations.fetch_add(1, std::memory_order_relaxed);
+	if (size == 0) size = 1;
+	while (true) {
+		void *p = std::malloc(size);
+		if (p) return p;
+		std::new_handler handler = std::get_new_handler();
+		if (!handler) throw std::bad_alloc();
+		handler();
+	}
+}
+
+void *operator new[](std::size_t size) {
+	return operator new(size);
+}
+
+void operator delete(void *p) noexcept {
+	countedFree(p);
+}
+
+void operator delete[](void *p) noexcept {
+	countedFree(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept {
+	countedFree(p);
+}
+
+void operator delete[](void *p, std::size_t) noexcept {
+	countedFree(p);
+}
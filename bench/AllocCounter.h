@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstddef>
+
+//  Number of calls to the global operator new so far, and to operator
+//  delete (of non-NULL pointers). AllocCounter.cpp replaces operator
+//  new/delete with counting versions, so the benchmarks can report
+//  allocations per frame and catch leaks. It is only linked into the
+//  benchmark executable; the game keeps the standard allocator.
+//
+long allocationCount();
+long freeCount();
+
+//  Allocations not freed yet
+//
+long liveAllocations();
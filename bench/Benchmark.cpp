@@ -0,0 +1,525 @@
+#include "Benchmark.h"
+#include "AllocCounter.h"
+#include "Sprite.h"
+#include "World.h"
+#include "SteerKernel.h"
+#include <iomanip>
+
+//  One row of results. Times are per step; nsPerItem is the mean step time
+//  divided by the number of sprites (or queries) the step worked on.
+//
+struct BenchResult {
+	string name;
+	int n = 0;
+	int steps = 0;
+	double nsPerItem = 0;
+	double p50 = 0;
+	double p90 = 0;
+	double p99 = 0;
+	double max = 0;
+	double allocsPerStep = 0;
+};
+
+static float sink = 0;      // keeps the compiler from dropping the work
+
+// wall clock in nanoseconds
+//
+static double nanos() {
+	return std::chrono::duration<double, std::nano>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//  Run step() for some warm up steps, then time each of "steps" calls and
+//  count the allocations they make. n is the number of items each step
+//  works on, or a function returning it when it changes from step to step.
+//
+static BenchResult measure(string name, int steps, std::function<int()> n, std::function<void()> step) {
+	for (int i = 0; i < steps / 10; i++) step();
+
+	vector<double> times(steps);
+	double items = 0;
+	long allocs = allocationCount();
+	for (int i = 0; i < steps; i++) {
+		double start = nanos();
+		step();
+		times[i] = nanos() - start;
+		items += n();
+	}
+	allocs = allocationCount() - allocs;
+
+	BenchResult r;
+	r.name = name;
+	r.n = round(items / steps);
+	r.steps = steps;
+	double total = 0;
+	for (int i = 0; i < steps; i++) total += times[i];
+	r.nsPerItem = total / MAX(items, 1.0);
+	r.allocsPerStep = double(allocs) / steps;
+	sort(times.begin(), times.end());
+	r.p50 = times[steps * 50 / 100];
+	r.p90 = times[steps * 90 / 100];
+	r.p99 = times[steps * 99 / 100];
+	r.max = times[steps - 1];
+	return r;
+}
+
+//  A world in a 1920x1080 arena, on a step clock, that only spawns what
+//  the benchmark asks for. Sprites live forever unless a lifespan is set.
+//
+static void setupWorld(World &world, StepClock &clock) {
+	world.setup(&clock, 1, 1920, 1080);
+	Emitter *emitters[2] = { world.enemyEmitter, world.beamEmitter };
+	for (int i = 0; i < 2; i++) {
+		emitters[i]->setRate(1e-6);
+		emitters[i]->setLifespan(-1);
+		emitters[i]->setCapacity(100000);
+	}
+}
+
+//  N enemies chasing the player with the AgentEmitter::moveSprites kernel,
+//  on sprites copied in and out of it or directly on structOfArrays
+//  storage, moved on nThreads
+//
+static BenchResult benchChase(int n, spriteStorage storage, int nThreads = 1) {
+	World world;
+	StepClock clock;
+	setupWorld(world, clock);
+	world.setThreads(nThreads);
+	Emitter *enemies = world.enemyEmitter;
+	enemies->setStorage(storage);
+	enemies->setNAgents(n);
+	enemies->spawnSprite();
+
+	float dt = world.stepDt;
+	string name = storage == structOfArrays ? "chase_soa" : "chase";
+	if (nThreads != 1) name += "_t" + ofToString(nThreads);
+	return measure(name, 600, [&]() { return enemies->sys->size(); }, [&]() {
+		clock.advance(dt);
+		enemies->update(dt);
+	});
+}
+
+//  Chase for some steps on nThreads and return the enemies' final state
+//
+static vector<float> chaseState(int n, spriteStorage storage, int nThreads) {
+	World world;
+	StepClock clock;
+	setupWorld(world, clock);
+	world.setThreads(nThreads);
+	Emitter *enemies = world.enemyEmitter;
+	enemies->setStorage(storage);
+	enemies->setNAgents(n);
+	enemies->spawnSprite();
+	for (int i = 0; i < 300; i++) {
+		clock.advance(world.stepDt);
+		enemies->update(world.stepDt);
+	}
+	vector<float> state;
+	for (int i = 0; i < enemies->sys->size(); i++) {
+		Sprite s = enemies->sys->load(i);
+		state.push_back(s.pos.x);
+		state.push_back(s.pos.y);
+		state.push_back(s.rot);
+		state.push_back(s.velocity.x);
+		state.push_back(s.velocity.y);
+	}
+	return state;
+}
+
+//  Chase on 1, 2, 4 .. up to the hardware threads, and check that the
+//  threaded runs end up bit for bit where the serial run does.
+//  Returns false if they don't.
+//
+static bool benchThreadScaling(vector<BenchResult> &results) {
+	int n = 5000;
+	int maxThreads = MAX(1, int(std::thread::hardware_concurrency()));
+	vector<int> counts;
+	for (int t = 1; t < maxThreads; t *= 2) counts.push_back(t);
+	counts.push_back(maxThreads);
+
+	bool identical = true;
+	spriteStorage storages[2] = { arrayOfSprites, structOfArrays };
+	for (int s = 0; s < 2; s++) {
+		vector<float> serial = chaseState(n, storages[s], 1);
+		for (int i = 0; i < counts.size(); i++) {
+			BenchResult r = benchChase(n, storages[s], counts[i]);
+			if (counts[i] == 1) r.name += "_t1";
+			results.push_back(r);
+			if (counts[i] == 1) continue;
+			vector<float> threaded = chaseState(n, storages[s], counts[i]);
+			if (threaded.size() != serial.size() ||
+				memcmp(threaded.data(), serial.data(), serial.size() * sizeof(float)) != 0) {
+				cerr << r.name << ": results differ from the serial run" << endl;
+				identical = false;
+			}
+		}
+	}
+	return identical;
+}
+
+//  M beams flying through N chasing enemies, with the broad phase grid and
+//  the narrow phase checks of World::collideBeams. Hit enemies are not
+//  removed, so the load stays the same from step to step.
+//
+static BenchResult benchBeams(int m, int n) {
+	World world;
+	StepClock clock;
+	setupWorld(world, clock);
+	world.enemyEmitter->setNAgents(n);
+	world.enemyEmitter->spawnSprite();
+
+	// beams go out from the player in a fan, like a burst of fire
+	Emitter *beams = world.beamEmitter;
+	for (int i = 0; i < m; i++) {
+		Sprite beam;
+		beam.setHeight(60);
+		beam.setWidth(40);
+		beam.pos = world.player->pos;
+		beam.rot = 360.0 * i / m;
+		beam.velocity = beam.heading() * 600;
+		beam.scale = glm::vec3(world.settings.scale);
+		beams->sys->add(beam);
+	}
+
+	float dt = world.stepDt;
+	int hits = 0;
+	BenchResult r = measure("beams_" + ofToString(m), 600, [&]() { return m + n; }, [&]() {
+		clock.advance(dt);
+		world.enemyEmitter->sys->savePrevious();
+		beams->sys->savePrevious();
+		world.enemyEmitter->update(dt);
+		beams->update(dt);
+		for (int i = 0; i < beams->sys->sprites.size(); i++) {
+			world.checkBorder(beams->sys->sprites[i]);
+		}
+		hits += world.collideBeams();
+		world.clearScratch();
+	});
+	sink += hits;
+	return r;
+}
+
+//  Beams at the top beam speed (5000 px/s) fired at a still enemy on a
+//  30 Hz step, each starting a little further away. A beam moves about
+//  167 px a step, much more than the enemy is wide, so only the swept test
+//  in World::collideBeams sees most of them hit.  Returns false if any
+//  beam goes through.
+//
+static bool benchTunneling() {
+	const int nBeams = 100;
+	World world;
+	StepClock clock;
+	setupWorld(world, clock);
+	float dt = 1.0 / 30;
+	Sprite enemy;
+	enemy.setWidth(40);
+	enemy.setHeight(60);
+	enemy.pos = glm::vec3(1000, 500, 0);
+	enemy.savePrevious();
+	world.enemyEmitter->sys->add(enemy);
+
+	SpriteList *beams = world.beamEmitter->sys;
+	int hits = 0;
+	for (int i = 0; i < nBeams; i++) {
+		beams->clear();
+		Sprite beam;
+		beam.setWidth(4);
+		beam.setHeight(20);
+		beam.rot = 90;      // heading (1, 0)
+		beam.pos = glm::vec3(700 - i * 5000 * dt / nBeams, 500 + i % 20 - 10, 0);
+		beam.velocity = glm::vec3(5000, 0, 0);
+		beams->add(beam);
+		for (int s = 0; s < 10; s++) {
+			beams->savePrevious();
+			clock.advance(dt);
+			world.beamEmitter->update(dt);
+			int n = world.collideBeams();
+			world.clearScratch();
+			if (n > 0) {
+				hits++;
+				break;
+			}
+		}
+	}
+	cout << "beams hitting an enemy at 5000 px/s, 30 Hz: " << hits << " of " << nBeams << endl;
+	return hits == nBeams;
+}
+
+//  nPerStep explosions of 10 particles a step at random places, each
+//  particle living a second (what World::explodeEnemies does for every
+//  hit). With many explosions the particle ring is full and the cost per
+//  step stays at its capacity
+//
+static BenchResult benchBursts(int nPerStep) {
+	World world;
+	StepClock clock;
+	setupWorld(world, clock);
+	ParticleBuffer &explosions = world.explosions;
+
+	float dt = world.stepDt;
+	string name = nPerStep == 1 ? "bursts" : "bursts_x" + ofToString(nPerStep);
+	return measure(name, 600, [&]() { return explosions.size(); }, [&]() {
+		clock.advance(dt);
+		for (int i = 0; i < nPerStep; i++) {
+			world.explode(glm::vec3(world.random(0, world.width), world.random(0, world.height), 0));
+		}
+		explosions.update(world.time(), dt);
+	});
+}
+
+//  Lifetime expiry of 10000 sprites that live 1 to 600 seconds, so only a
+//  few die in each step. With the expiry heap the time per step follows
+//  the deaths, not the number of sprites
+//
+static BenchResult benchExpire() {
+	World world;
+	StepClock clock;
+	setupWorld(world, clock);
+	SpriteList *sys = world.enemyEmitter->sys;
+	Sprite s;
+	for (int i = 0; i < 10000; i++) {
+		s.lifespan = world.random(1000, 600000);
+		sys->add(s);
+	}
+
+	float dt = world.stepDt;
+	return measure("expire", 600, [&]() { return sys->size(); }, [&]() {
+		clock.advance(dt);
+		sys->expire(world.time());
+	});
+}
+
+//  The swarm of bin/data/waves/swarm.txt (10000 enemies from the four
+//  edges in the first 5 seconds) spawned by the wave scheduler, in full
+//  World steps on all hardware threads like the game. Returns false if the
+//  wave file can't be loaded.
+//
+static bool benchWaves(vector<BenchResult> &results) {
+	WaveSchedule waves;
+	if (!waves.load("waves/swarm.txt")) {
+		cerr << "can't load waves/swarm.txt" << endl;
+		return false;
+	}
+
+	World world;
+	StepClock clock;
+	world.waves = &waves;
+	setupWorld(world, clock);
+	world.setThreads(0);
+	results.push_back(measure("waves_10k", 600, [&]() { return world.enemyEmitter->sys->size(); }, [&]() {
+		world.step(world.stepDt);
+	}));
+	return true;
+}
+
+//  The chase step alone on 5000 enemies, with each instruction set this
+//  CPU has, against the scalar loop
+//
+static void benchSteerKernels(vector<BenchResult> &results) {
+	const int n = 5000;
+	std::mt19937 rng(1);
+	std::uniform_real_distribution<float> r(0, 1);
+	SpriteArrays arrays;
+	for (int i = 0; i < n; i++) {
+		Sprite s;
+		s.pos = glm::vec3(r(rng) * 1920, r(rng) * 1080, 0);
+		s.rot = r(rng) * 360;
+		s.velocity = glm::vec3(150, 150, 0);
+		arrays.push(s);
+	}
+	SteerParams p;
+	p.target = glm::vec3(960, 540, 0);
+	p.turn = 3;
+	p.eps = .0005;
+	p.force = 500;
+	p.acceleration = glm::vec3(0, 0, 0);
+	p.invMass = 1;
+	p.angularAcceleration = 0;
+	p.damping = .96;
+	p.dt = 1.0 / 60;
+
+	for (int isa = steerScalar; isa <= steerBestIsa(); isa++) {
+		SpriteArrays a = arrays;
+		results.push_back(measure(string("steer_") + steerIsaName(steerIsa(isa)), 600,
+			[]() { return n; }, [&]() { steerChase(a, 0, n, p, steerIsa(isa)); }));
+	}
+}
+
+//  Soak test of World::setup as a restart: one world plays hundreds of
+//  short games (spawning, firing, exploding), set up again before each.
+//  After some warm up games the pools, vectors and the frame arena are at
+//  their size, so a game must not allocate at all (every frame is a
+//  steady-state frame) and live allocations must not grow from game to
+//  game. Returns false if either happens.
+//
+static bool benchRestarts(vector<BenchResult> &results) {
+	const int nGames = 300;
+	const int nSteps = 120;
+	World world;
+	StepClock clock;
+	auto game = [&]() {
+		world.setup(&clock, 1, 1920, 1080);
+		WorldSettings settings;
+		settings.rate = 30;
+		settings.nAgents = 3;
+		world.setSettings(settings);
+		for (int i = 0; i < nSteps; i++) {
+			world.controls.up = (i % 40) < 20;
+			world.controls.left = (i % 30) < 10;
+			if (i % 15 == 0) world.fire();
+			world.step(world.stepDt);
+		}
+	};
+	for (int i = 0; i < 20; i++) game();
+
+	long live = liveAllocations();
+	BenchResult r = measure("restart", nGames, []() { return 1; }, game);
+	long leaked = liveAllocations() - live;
+	results.push_back(r);
+	cout << "live allocations after " << nGames << " restarts: " << (leaked >= 0 ? "+" : "") << leaked
+		<< ", allocations per frame: " << r.allocsPerStep / nSteps << endl;
+	return leaked <= 0 && r.allocsPerStep == 0;
+}
+
+// heading the way Sprite::heading found it before the cos/sin cache: a
+// full rotation matrix times a vec4
+//
+static glm::vec3 headingMatrix(Sprite &s) {
+	glm::mat4 rot2 = glm::rotate(glm::mat4(1.0), glm::radians(s.rot), glm::vec3(0, 0, 1));
+	return glm::normalize(rot2 * glm::vec4(0, -1, 0, 1));
+}
+
+//  Per-sprite steering like AgentEmitter::moveSprite (direction to the
+//  player, heading, dot and cross, turn), with the old matrix heading and
+//  with the cached cos/sin one
+//
+static void benchHeading(vector<BenchResult> &results) {
+	const int n = 5000;
+	std::mt19937 rng(1);
+	std::uniform_real_distribution<float> r(0, 1);
+	vector<Sprite> sprites(n);
+	for (int i = 0; i < n; i++) {
+		sprites[i].pos = glm::vec3(r(rng) * 1920, r(rng) * 1080, 0);
+		sprites[i].rot = r(rng) * 360;
+	}
+	glm::vec3 target(960, 540, 0);
+
+	for (int cached = 0; cached < 2; cached++) {
+		vector<Sprite> s = sprites;
+		results.push_back(measure(cached ? "heading_cossin" : "heading_matrix", 300,
+			[]() { return n; }, [&]() {
+			for (int i = 0; i < n; i++) {
+				glm::vec3 v = glm::normalize(target - s[i].pos);
+				glm::vec3 h = cached ? s[i].heading() : headingMatrix(s[i]);
+				float dotp = glm::dot(h, v);
+				glm::vec3 crossp = glm::cross(h, v);
+				if (dotp < 1 - .0005) s[i].rot += crossp.z > 0 ? 3 : -3;
+			}
+		}));
+	}
+}
+
+// object space point the way Sprite::insidePoint found it before the
+// transform was cached: build T*R*S and take a full 4x4 inverse per query
+//
+static glm::vec3 toObjectUncached(Sprite &s, glm::vec3 p) {
+	glm::mat4 T = glm::translate(glm::mat4(1.0), glm::vec3(s.pos));
+	glm::mat4 R = glm::rotate(glm::mat4(1.0), glm::radians(s.rot), glm::vec3(0, 0, 1));
+	glm::mat4 S = glm::scale(glm::mat4(1.0), s.scale);
+	return glm::inverse(T*R*S) * glm::vec4(p, 1);
+}
+
+//  Cost of one point query into sprite space, before and after caching
+//  the transform and its inverse on Shape. Each sprite is queried with a
+//  batch of points per frame, like the collision checks do.
+//
+static void benchTransformQueries(vector<BenchResult> &results) {
+	const int nSprites = 1000;
+	const int nPoints = 6;      // checkCollision tests 6 points per pair
+	std::mt19937 rng(1);
+	std::uniform_real_distribution<float> r(0, 1);
+
+	vector<Sprite> sprites(nSprites);
+	vector<glm::vec3> points(nPoints);
+	for (int i = 0; i < nSprites; i++) {
+		sprites[i].pos = glm::vec3(r(rng) * 1920, r(rng) * 1080, 0);
+		sprites[i].rot = r(rng) * 360;
+		sprites[i].setScale(.5 + r(rng));
+	}
+	for (int i = 0; i < nPoints; i++) {
+		points[i] = glm::vec3(r(rng) * 1920, r(rng) * 1080, 0);
+	}
+
+	auto queries = []() { return nSprites * nPoints; };
+	results.push_back(measure("transform_uncached", 100, queries, [&]() {
+		for (int i = 0; i < nSprites; i++) {
+			for (int j = 0; j < nPoints; j++) {
+				sink += toObjectUncached(sprites[i], points[j]).x;
+			}
+		}
+	}));
+	results.push_back(measure("transform_cached", 100, queries, [&]() {
+		for (int i = 0; i < nSprites; i++) {
+			// the sprites move every frame, so each frame rebuilds the cache once
+			sprites[i].pos.x += 1;
+			for (int j = 0; j < nPoints; j++) {
+				glm::vec3 s = sprites[i].getInverseTransform() * glm::vec4(points[j], 1);
+				sink += s.x;
+			}
+		}
+	}));
+	results.push_back(measure("transform_cossin", 100, queries, [&]() {
+		for (int i = 0; i < nSprites; i++) {
+			sprites[i].pos.x += 1;
+			for (int j = 0; j < nPoints; j++) {
+				sink += sprites[i].toObject(points[j]).x;
+			}
+		}
+	}));
+}
+
+//  Runs every scenario, prints a table and writes the same rows as CSV to
+//  the file named by the first argument (bench.csv by default), so runs
+//  can be diffed.
+//
+int runBenchmarks(int argc, char *argv[]) {
+	string path = argc > 1 ? argv[1] : "bench.csv";
+	vector<BenchResult> results;
+
+	int sizes[3] = { 100, 1000, 5000 };
+	for (int i = 0; i < 3; i++) {
+		results.push_back(benchChase(sizes[i], arrayOfSprites));
+		results.push_back(benchChase(sizes[i], structOfArrays));
+	}
+	results.push_back(benchBeams(10, 1000));
+	results.push_back(benchBeams(100, 1000));
+	results.push_back(benchBursts(1));
+	results.push_back(benchBursts(50));
+	bool waved = benchWaves(results);
+	results.push_back(benchExpire());
+	benchTransformQueries(results);
+	benchSteerKernels(results);
+	benchHeading(results);
+	bool identical = benchThreadScaling(results);
+	bool steady = benchRestarts(results);
+	bool swept = benchTunneling();
+
+	ofstream csv(path);
+	if (!csv) {
+		cerr << "can't write " << path << endl;
+		return 1;
+	}
+	csv << "name,n,steps,ns_per_item,p50_ns,p90_ns,p99_ns,max_ns,allocs_per_step" << endl;
+	cout << left << setw(20) << "name" << setw(8) << "n" << setw(14) << "ns/item"
+		<< setw(12) << "p50 us" << setw(12) << "p99 us" << "allocs/step" << endl;
+	for (int i = 0; i < results.size(); i++) {
+		BenchResult &r = results[i];
+		csv << r.name << "," << r.n << "," << r.steps << "," << r.nsPerItem << ","
+			<< r.p50 << "," << r.p90 << "," << r.p99 << "," << r.max << ","
+			<< r.allocsPerStep << endl;
+		cout << left << setw(20) << r.name << setw(8) << r.n << setw(14) << r.nsPerItem
+			<< setw(12) << r.p50 / 1000 << setw(12) << r.p99 / 1000 << r.allocsPerStep << endl;
+	}
+	cout << "wrote " << path << " (" << sink << ")" << endl;
+	return waved && identical && steady && swept ? 0 : 1;
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include "ofMain.h"
+
+//  Headless benchmarks of the game's hot paths: enemies chasing the
+//  player, beams against enemies, explosion bursts, transform queries, the
+//  SIMD chase kernels, the chase on 1..N threads (which must match the
+//  serial chase exactly) and a restart soak test (which must not leak).
+//  They don't open a window, so they can run on build machines. They are
+//  built as their own executable (bench/main.cpp, "Dynamic Pursuit Bench"),
+//  run it as "Dynamic Pursuit Bench [file.csv]". The wave benchmark loads
+//  waves/swarm.txt from the data folder next to the executable (bin/data).
+//
+int runBenchmarks(int argc, char *argv[]);
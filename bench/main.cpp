@@ -0,0 +1,9 @@
+#include "ofMain.h"
+#include "Benchmark.h"
+
+//========================================================================
+// The headless benchmarks, built apart from the game so that only they
+// link the counting operator new/delete in AllocCounter.cpp
+int main(int argc, char *argv[]){
+	return runBenchmarks(argc, argv);
+}
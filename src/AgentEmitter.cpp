@@ -0,0 +1,156 @@
+#include "AgentEmitter.h"
+#include "World.h"
+
+// spawnSprite - we override this function in the Emitter class to spawn our 
+// "custom" Agent sprite.
+//
+void AgentEmitter::spawnSprite() {
+	for (int i = 0; i < nAgents; i++) {
+		Sprite &sprite = spawned;
+		sprite.reset();
+		if (haveChildImage) {
+			sprite.setImage(childImage, childMask);
+		}
+		else {
+			sprite.bHighlight = true;
+			sprite.setHeight(abs(sprite.verts[0].y) + abs(sprite.verts[2].y));
+			sprite.setWidth(abs(sprite.verts[0].x) + abs(sprite.verts[1].x));
+		}
+		sprite.velocity = velocity;
+		sprite.lifespan = lifespan;
+		switch (emitterType) {
+		case enemySpawner:
+			sprite.pos = glm::vec3(world->random(0, world->width), world->random(0, world->height), 0);
+			sprite.rot = world->random(0, 360);
+			sprite.birthtime = world->time();
+			sys->add(sprite);
+			break;
+		case playerFire:
+			sprite.pos = pos;
+			sprite.rot = rot;
+			sprite.birthtime = world->time();
+			if (sprite.birthtime - lastSpawned > 1000) {
+				lastSpawned = sprite.birthtime;
+				sys->add(sprite);
+			}
+			break;
+		case explosion:
+			sprite.pos = glm::vec3(pos.x + world->random(-10,10), pos.y + world->random(-10, 10), 0);
+			sprite.rot = rot;
+			sprite.addForces(glm::vec3(world->random(-10000, 10000), world->random(-10000, 10000), 0));
+			sprite.birthtime = world->time();
+			sys->add(sprite);
+			break;
+		}
+	}
+}
+
+// spawnBurst - the enemies of a wave burst, set up like spawnSprite does
+// for enemySpawner but placed in the burst's region. The sprite is set up
+// once for the whole burst.
+//
+void AgentEmitter::spawnBurst(const SpawnEvent &e) {
+	Sprite &sprite = spawned;
+	sprite.reset();
+	if (haveChildImage) {
+		sprite.setImage(childImage, childMask);
+	}
+	else {
+		sprite.bHighlight = true;
+		sprite.setHeight(abs(sprite.verts[0].y) + abs(sprite.verts[2].y));
+		sprite.setWidth(abs(sprite.verts[0].x) + abs(sprite.verts[1].x));
+	}
+	sprite.velocity = e.velocity;
+	sprite.lifespan = e.lifespan;
+	sprite.birthtime = world->time();
+	for (int i = 0; i < e.count; i++) {
+		sprite.pos = glm::vec3(world->random(e.x, e.x + e.w) * world->width, world->random(e.y, e.y + e.h) * world->height, 0);
+		sprite.rot = world->random(0, 360);
+		if (!sys->add(sprite)) break;
+	}
+}
+
+//  moveSprites - the enemies chase the player in a single loop over the
+//  sprite arrays. This is the same math as moveSprite() below (heading,
+//  turn, Sprite::integrate and Emitter::moveSprite) inlined, run several
+//  sprites at a time with the widest SIMD the CPU has (see SteerKernel).
+//  In arrayOfSprites mode each chunk copies its sprites into "steer", runs
+//  the kernel there and copies them back. The kernel takes one turn speed,
+//  mass and damping for the whole list, from the archetype, which the
+//  style system keeps in step with the sprites.
+//
+void AgentEmitter::moveSprites(float dt) {
+	if (emitterType != enemySpawner) {
+		Emitter::moveSprites(dt);
+		return;
+	}
+	Sprite &proto = sys->archetype;
+	SteerParams p;
+	p.target = world->player->pos;
+	p.turn = proto.rotationSpeed;
+	p.eps = .0005;
+	p.force = 500;
+	p.acceleration = proto.acceleration;
+	p.invMass = 1.0f / proto.mass;
+	p.angularAcceleration = proto.angularAcceleration;
+	p.damping = proto.damping;
+	p.dt = dt;
+	if (sys->storage == structOfArrays) {
+		SpriteArrays &a = sys->arrays;
+		forEachChunk(a.size(), [&](int begin, int end) {
+			steerChase(a, begin, end, p, isa);
+		});
+		return;
+	}
+	vector<Sprite> &sprites = sys->sprites;
+	steer.reserve(sys->capacity);
+	steer.resize(sprites.size());
+	forEachChunk(sprites.size(), [&](int begin, int end) {
+		for (int i = begin; i < end; i++) {
+			steer.write(i, sprites[i]);
+		}
+		steerChase(steer, begin, end, p, isa);
+		for (int i = begin; i < end; i++) {
+			steer.read(i, sprites[i]);
+		}
+	});
+}
+
+//  moveSprite - we override this function in the Emitter class to implment
+//  "following" motion towards the player
+//
+void AgentEmitter::moveSprite(Sprite* sprite, float dt) {
+
+	// rotate sprite to point towards player
+	//  - find vector "v" from sprite to player
+	//  - set rotation of sprite to align with v
+	//
+
+	glm::vec3 v = glm::normalize(world->player->pos - sprite->pos);
+	glm::vec3 h = sprite->heading();
+	float dotp = glm::dot(h, v);
+	float eps = .0005;
+	float sp = sprite->rotationSpeed;
+	glm::vec3 crossp = glm::cross(h, v);
+	switch (emitterType) {
+	case enemySpawner:
+		if (dotp < (1.0 - eps)) {
+			if (crossp.z > 0.0) {
+				sprite->rot += sp;
+			}
+			else {
+				sprite->rot -= sp;
+			}
+		}
+		sprite->addForces(500 * v);
+		sprite->integrate(dt);
+		break;
+	}
+
+	// Calculate new velocity vector
+	// with same speed (magnitude) as the old one but in direction of "v"
+	// 	
+	// Now move the sprite in the normal way (along velocity vector)
+	//
+	Emitter::moveSprite(sprite, dt);
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "ofMain.h"
+#include "Emitter.h"
+#include "Sprite.h"
+#include "SteerKernel.h"
+
+class Agent : public Sprite {
+public:
+	Agent() {
+		Sprite::Sprite();
+//		cout << "in Agent Constuctor" << endl;
+	}
+};
+
+//  Emitter for the game's agents: enemies that chase the player, the
+//  player's beams and explosion fragments (see emitterType)
+//
+class AgentEmitter : public Emitter {
+public:
+	void spawnSprite();
+	void spawnBurst(const SpawnEvent &e);
+	void moveSprite(Sprite*, float dt);
+	void moveSprites(float dt);
+
+	steerIsa isa = steerBestIsa();  // for the enemy chase (see moveSprites)
+	SpriteArrays steer;             // enemy state copied in and out of steerChase
+};
@@ -0,0 +1,108 @@
+#include "AlphaMask.h"
+
+AlphaMask::AlphaMask() {
+	width = 0;
+	height = 0;
+	wordsPerRow = 0;
+}
+
+//  Set a bit for every pixel that isn't fully transparent. Images without
+//  an alpha channel are opaque everywhere.
+//
+void AlphaMask::build(ofImage &img) {
+	build(img.getPixels());
+}
+
+void AlphaMask::build(ofPixels &pixels) {
+	width = pixels.getWidth();
+	height = pixels.getHeight();
+	wordsPerRow = (width + 63) / 64;
+	bits.assign(wordsPerRow * height, 0);
+
+	int channels = pixels.getNumChannels();
+	unsigned char *data = pixels.getData();
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
+			bool opaque = true;
+			if (channels == 4) opaque = data[(y * width + x) * 4 + 3] != 0;
+			if (opaque) bits[y * wordsPerRow + (x >> 6)] |= uint64_t(1) << (x & 63);
+		}
+	}
+}
+
+//  Is pixel x, y opaque
+//
+bool AlphaMask::test(int x, int y) {
+	if (x < 0 || x >= width || y < 0 || y >= height) return false;
+	return (bits[y * wordsPerRow + (x >> 6)] >> (x & 63)) & 1;
+}
+
+//  Same as test() for a point in the sprite's object space, where the
+//  image is centered on the origin (see Sprite::draw)
+//
+bool AlphaMask::testLocal(glm::vec3 p) {
+	return test(floor(p.x + width / 2.0), floor(p.y + height / 2.0));
+}
+
+//  Do the opaque pixels of this mask and another mask overlap. toOther
+//  maps this sprite's object space to the other's, fromOther the reverse
+//  (other.inverse * this.transform and this.inverse * other.transform).
+//
+//  Only the part of this mask covered by the other image is visited. For
+//  each 64 pixel word of a row that has opaque pixels, the other mask is
+//  sampled at the same 64 pixel centers into a word, and the two words
+//  are ANDed.
+//
+bool AlphaMask::overlaps(AlphaMask &other, const glm::mat4 &toOther, const glm::mat4 &fromOther) {
+
+	// bounds of the other image in this mask's pixels
+	//
+	float ow = other.width / 2.0;
+	float oh = other.height / 2.0;
+	glm::vec3 corners[4] = {
+		glm::vec3(-ow, -oh, 0), glm::vec3(ow, -oh, 0),
+		glm::vec3(ow, oh, 0), glm::vec3(-ow, oh, 0)
+	};
+	float minX = width, minY = height, maxX = 0, maxY = 0;
+	for (int i = 0; i < 4; i++) {
+		glm::vec3 p = fromOther * glm::vec4(corners[i], 1);
+		minX = MIN(minX, p.x + width / 2.0f);
+		minY = MIN(minY, p.y + height / 2.0f);
+		maxX = MAX(maxX, p.x + width / 2.0f);
+		maxY = MAX(maxY, p.y + height / 2.0f);
+	}
+	int startX = MAX(0, int(floor(minX)));
+	int startY = MAX(0, int(floor(minY)));
+	int endX = MIN(width - 1, int(ceil(maxX)));
+	int endY = MIN(height - 1, int(ceil(maxY)));
+	if (startX > endX || startY > endY) return false;
+
+	// center of pixel (startX, startY) in the other's object space, and
+	// how far one pixel step in x or y moves in that space
+	//
+	glm::vec3 base = toOther * glm::vec4(startX + .5 - width / 2.0, startY + .5 - height / 2.0, 0, 1);
+	glm::vec3 dx = glm::vec3(toOther[0]);
+	glm::vec3 dy = glm::vec3(toOther[1]);
+
+	for (int y = startY; y <= endY; y++) {
+		glm::vec3 rowStart = base + dy * float(y - startY);
+		uint64_t *row = &bits[y * wordsPerRow];
+		for (int w = startX >> 6; w <= (endX >> 6); w++) {
+			if (row[w] == 0) continue;
+			int first = MAX(startX, w * 64);
+			int last = MIN(endX, w * 64 + 63);
+			uint64_t sampled = 0;
+			glm::vec3 p = rowStart + dx * float(first - startX);
+			for (int x = first; x <= last; x++) {
+				if (other.testLocal(p)) sampled |= uint64_t(1) << (x & 63);
+				p += dx;
+			}
+			if (sampled & row[w]) return true;
+		}
+	}
+	return false;
+}
+
+size_t AlphaMask::bytes() {
+	return bits.size() * sizeof(uint64_t);
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "ofMain.h"
+
+//  1 bit per pixel opacity mask of an image, each row packed into 64 bit
+//  words. Built once per image (see ImageRegistry) and shared by every
+//  sprite that uses the image, so collision tests don't have to go through
+//  ofImage pixel access.
+//
+class AlphaMask {
+public:
+	AlphaMask();
+	void build(ofImage &img);
+	void build(ofPixels &pixels);
+	bool test(int x, int y);
+	bool testLocal(glm::vec3 p);
+	bool overlaps(AlphaMask &other, const glm::mat4 &toOther, const glm::mat4 &fromOther);
+	size_t bytes();
+
+	int width;
+	int height;
+	int wordsPerRow;
+	vector<uint64_t> bits;
+};
@@ -0,0 +1,91 @@
+#include "AssetLoader.h"
+
+AssetLoader::~AssetLoader() {
+	clear();
+}
+
+void AssetLoader::addImage(string path) {
+	Job *job = new Job();
+	job->path = path;
+	job->done = false;
+	jobs.push_back(job);
+}
+
+void AssetLoader::addTask(std::function<void()> task) {
+	Job *job = new Job();
+	job->task = task;
+	job->done = false;
+	jobs.push_back(job);
+}
+
+//  Start a thread for every asset that isn't loaded yet
+//
+void AssetLoader::start(ImageRegistry *images) {
+	this->images = images;
+	for (int i = 0; i < jobs.size(); i++) {
+		Job *job = jobs[i];
+		if (job->path != "" && images->find(job->path) != NULL) {
+			job->done = true;
+			job->finished = true;
+			continue;
+		}
+		threads.push_back(std::thread(&AssetLoader::run, this, job));
+	}
+}
+
+//  Background thread: decode the image without touching GL, or run the task
+//
+void AssetLoader::run(Job *job) {
+	if (job->path != "") {
+		job->ok = ofLoadImage(job->pixels, job->path);
+		if (job->ok) job->mask.build(job->pixels);
+	}
+	else {
+		job->task();
+	}
+	job->done = true;
+}
+
+//  Main thread: give decoded images to the registry (uploading their
+//  textures). Returns true once every asset is done.
+//
+bool AssetLoader::update() {
+	bool all = true;
+	for (int i = 0; i < jobs.size(); i++) {
+		Job *job = jobs[i];
+		if (!job->done) {
+			all = false;
+			continue;
+		}
+		if (job->finished) continue;
+		if (job->path != "") {
+			if (job->ok) images->add(job->path, job->pixels, job->mask);
+			else cout << "Can't open image file " << job->path << endl;
+		}
+		job->finished = true;
+	}
+	if (all) clear();
+	return all;
+}
+
+//  Fraction of the assets done, 1 when there is nothing left to load
+//
+float AssetLoader::progress() {
+	if (jobs.empty()) return 1;
+	int n = 0;
+	for (int i = 0; i < jobs.size(); i++) {
+		if (jobs[i]->done) n++;
+	}
+	return float(n) / jobs.size();
+}
+
+void AssetLoader::clear() {
+	for (int i = 0; i < threads.size(); i++) {
+		threads[i].join();
+	}
+	threads.clear();
+	for (int i = 0; i < jobs.size(); i++) {
+		delete jobs[i];
+	}
+	jobs.clear();
+}
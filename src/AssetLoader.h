@@ -0,0 +1,41 @@
+#pragma once
+
+#include "ofMain.h"
+#include "ImageRegistry.h"
+
+//  Loads the game's assets on background threads, one thread per asset.
+//  Images are decoded to pixels (and their AlphaMask built) off the main
+//  thread; update(), on the main thread, then hands them to the
+//  ImageRegistry, which uploads the textures. Other assets (the wave
+//  file) are loaded by a task run on a background thread.
+//
+//  Images already in the registry are skipped, so loading again after a
+//  restart finishes on the first update().
+//
+class AssetLoader {
+public:
+	~AssetLoader();
+	void addImage(string path);
+	void addTask(std::function<void()> task);
+	void start(ImageRegistry *images);
+	bool update();
+	float progress();
+
+private:
+	struct Job {
+		string path;                    // image to decode, "" for a task
+		std::function<void()> task;
+		ofPixels pixels;
+		AlphaMask mask;
+		bool ok = false;
+		std::atomic<bool> done;
+		bool finished = false;          // handed to the registry
+	};
+
+	void run(Job *job);
+	void clear();
+
+	ImageRegistry *images = NULL;
+	vector<Job *> jobs;
+	vector<std::thread> threads;
+};
@@ -0,0 +1,105 @@
+#include "AudioSystem.h"
+
+AudioSystem::~AudioSystem() {
+	stop();
+}
+
+//  Ask for a sound to be loaded into nVoices players. Call before start(),
+//  the audio thread loads it when it starts.
+//
+void AudioSystem::load(soundId sound, string path, bool loop, float volume, int nVoices) {
+	Voices &v = voices[sound];
+	v.path = path;
+	v.loop = loop;
+	v.volume = volume;
+	v.nVoices = nVoices;
+}
+
+//  Audio thread: load every sound asked for, one at a time
+//
+void AudioSystem::loadSounds() {
+	for (int s = 0; s < nSounds; s++) {
+		Voices &v = voices[s];
+		v.players.resize(v.nVoices);
+		for (int i = 0; i < v.nVoices; i++) {
+			v.players[i].load(v.path);
+			v.players[i].setLoop(v.loop);
+			v.players[i].setVolume(v.volume);
+		}
+	}
+}
+
+void AudioSystem::start() {
+	if (!isThreadRunning()) startThread();
+}
+
+void AudioSystem::stop() {
+	if (isThreadRunning()) waitForThread(true);
+}
+
+void AudioSystem::send(soundEventType type, soundId sound, float value) {
+	SoundEvent e;
+	e.type = type;
+	e.sound = sound;
+	e.value = value;
+	if (!queue.push(e)) nDropped++;
+}
+
+void AudioSystem::play(soundId sound) {
+	send(soundPlay, sound, 0);
+}
+
+void AudioSystem::stop(soundId sound) {
+	send(soundStop, sound, 0);
+}
+
+void AudioSystem::setVolume(soundId sound, float volume) {
+	send(soundVolume, sound, volume);
+}
+
+//  Audio thread: load the sounds, then drain the queue, update FMOD and
+//  sleep a little
+//
+void AudioSystem::threadedFunction() {
+	loadSounds();
+	while (isThreadRunning()) {
+		SoundEvent e;
+		while (queue.pop(e)) {
+			handle(e);
+		}
+		ofSoundUpdate();
+		sleep(2);
+	}
+}
+
+void AudioSystem::handle(SoundEvent &e) {
+	Voices &v = voices[e.sound];
+	if (v.players.empty()) return;
+	switch (e.type) {
+	case soundPlay:
+		if (v.loop) {
+			if (!v.players[0].isPlaying()) v.players[0].play();
+			break;
+		}
+		for (int i = 0; i < v.players.size(); i++) {
+			if (!v.players[i].isPlaying()) {
+				v.players[i].play();
+				return;
+			}
+		}
+		v.players[v.next].stop();
+		v.players[v.next].play();
+		v.next = (v.next + 1) % v.players.size();
+		break;
+	case soundStop:
+		for (int i = 0; i < v.players.size(); i++) {
+			v.players[i].stop();
+		}
+		break;
+	case soundVolume:
+		for (int i = 0; i < v.players.size(); i++) {
+			v.players[i].setVolume(e.value);
+		}
+		break;
+	}
+}
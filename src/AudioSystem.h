@@ -0,0 +1,73 @@
+#pragma once
+
+#include "ofMain.h"
+#include "SpscQueue.h"
+
+enum soundId {
+	soundEngine,
+	soundBeam,
+	soundExplosion,
+	nSounds
+};
+
+enum soundEventType {
+	soundPlay,
+	soundStop,
+	soundVolume
+};
+
+struct SoundEvent {
+	soundEventType type;
+	soundId sound;
+	float value;
+};
+
+//  Plays the game's sounds on its own thread. The game thread only pushes
+//  events into a lock-free queue (play/stop/setVolume), so a slow sound
+//  call never holds up a frame. Events are dropped if the queue is full.
+//
+//  The sounds are loaded on the audio thread too, one after another before
+//  it handles the first event, so only that thread ever loads into FMOD.
+//
+//  The audio thread also runs the FMOD system update (ofSoundUpdate) after
+//  each batch of events, so the game thread never calls FMOD and never
+//  waits on it. openFrameworks' own ofSoundUpdate from its main loop is
+//  safe alongside it: the FMOD core API locks its System internally.
+//
+//  Each sound has a small pool of players (voices). Playing a looped sound
+//  that is already playing does nothing; playing a one-shot sound takes a
+//  free voice, or restarts the busy voices in turn, so overlapping
+//  explosions share a few players.
+//
+class AudioSystem : public ofThread {
+public:
+	~AudioSystem();
+	void load(soundId sound, string path, bool loop, float volume, int nVoices = 1);
+	void start();
+	void stop();
+
+	// game thread
+	void play(soundId sound);
+	void stop(soundId sound);
+	void setVolume(soundId sound, float volume);
+
+	int nDropped = 0;   // events lost to a full queue
+
+private:
+	struct Voices {
+		vector<ofSoundPlayer> players;
+		int next = 0;       // voice to restart when all are busy
+		bool loop = false;
+		string path;        // loaded by the audio thread when it starts
+		float volume = 1;
+		int nVoices = 0;
+	};
+
+	void threadedFunction();
+	void loadSounds();
+	void handle(SoundEvent &e);
+	void send(soundEventType type, soundId sound, float value);
+
+	SpscQueue<SoundEvent, 256> queue;
+	Voices voices[nSounds];
+};
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "ofMain.h"
+
+//  Time source for the World, in milliseconds. The game and headless runs
+//  use a StepClock, which only moves when the simulation is stepped, so
+//  lifespans and spawn times follow simulated time. AppClock follows the
+//  app's elapsed time instead.
+//
+class Clock {
+public:
+	virtual ~Clock() {}
+	virtual float now() = 0;
+	virtual void advance(float dt) {}
+	virtual void reset() {}
+};
+
+class AppClock : public Clock {
+public:
+	float now() {
+		return ofGetElapsedTimeMillis();
+	}
+};
+
+class StepClock : public Clock {
+public:
+	float now() {
+		return time;
+	}
+	// dt in seconds
+	void advance(float dt) {
+		time += dt * 1000;
+	}
+	void reset() {
+		time = 0;
+	}
+	float time = 0;
+};
@@ -1,4 +1,5 @@
-#include "ofApp.h"
+#include "Emitter.h"
+#include "World.h"
 //----------------------------------------------------------------------------------
 //
 // This example code demonstrates the use of an "Emitter" class to emit Sprites
@@ -29,72 +30,379 @@
 
 
 
-//  Add a Sprite to the Sprite System
+SpriteList::SpriteList() {
+	storage = arrayOfSprites;
+	setCapacity(1000);
+	bBatch = true;
+	drawCalls = 0;
+	imageMesh.setMode(OF_PRIMITIVE_TRIANGLES);
+	imageMesh.setUsage(GL_STREAM_DRAW);
+	shapeMesh.setMode(OF_PRIMITIVE_TRIANGLES);
+	shapeMesh.setUsage(GL_STREAM_DRAW);
+}
+
+//  Set the most sprites the list will hold. Storage for that many sprites
+//  is reserved up front so adding never reallocates.
 //
-void SpriteList::add(Sprite s) {
-	sprites.push_back(s);
+void SpriteList::setCapacity(int n) {
+	capacity = n;
+	sprites.reserve(n);
+	recycled.reserve(n);
+	arrays.reserve(n);
+	ids.reserve(n);
+	slots.reserve(n);
+	generations.reserve(n);
+	freeIds.reserve(n);
+	expiries.reserve(n);
 }
 
-// Remove a sprite from the sprite system. Note that this function is not currently
-// used. The typical case is that sprites automatically get removed when the reach
-// their lifespan.
+//  Construct sprites up front until the pool holds n (live and recycled),
+//  so spawning up to n sprites later doesn't allocate
+//
+void SpriteList::preallocate(int n) {
+	n = MIN(n, capacity);
+	while (sprites.size() + recycled.size() < n) {
+		recycled.push_back(archetype);
+		stats.nAllocated++;
+	}
+}
+
+//  Add a Sprite to the Sprite System. The sprite is copied into a recycled
+//  sprite if there is one, which reuses its verts and name storage.
+//  Returns false if the list is already at capacity.
+//
+bool SpriteList::add(const Sprite &s) {
+	if (size() >= capacity) {
+		stats.nExhausted++;
+		return false;
+	}
+	if (storage == structOfArrays) {
+		arrays.push(s);
+	}
+	else if (recycled.size() > 0) {
+		sprites.push_back(std::move(recycled.back()));
+		recycled.pop_back();
+		sprites.back() = s;
+		stats.nReused++;
+	}
+	else {
+		sprites.push_back(s);
+		stats.nAllocated++;
+	}
+	if (storage == arrayOfSprites) {
+		if (rules.bStyle) rules.style(sprites.back());
+		// a new sprite has no previous step to blend from
+		sprites.back().savePrevious();
+	}
+
+	int id;
+	if (freeIds.size() > 0) {
+		id = freeIds.back();
+		freeIds.pop_back();
+	}
+	else {
+		id = slots.size();
+		slots.push_back(-1);
+		generations.push_back(0);
+	}
+	slots[id] = ids.size();
+	ids.push_back(id);
+	if (s.lifespan != -1) {
+		Expiry e = { s.birthtime + s.lifespan, id, generations[id] };
+		expiries.push_back(e);
+		push_heap(expiries.begin(), expiries.end(), laterExpiry);
+	}
+	stats.peak = MAX(stats.peak, size());
+	return true;
+}
+
+// Remove a sprite from the sprite system by swapping the last sprite into
+// its place, so nothing after it has to be shifted. The removed sprite is
+// kept for reuse by add().
 //
 void SpriteList::remove(int i) {
-	sprites.erase(sprites.begin() + i);
+	int id = ids[i];
+	ids[i] = ids.back();
+	slots[ids[i]] = i;
+	ids.pop_back();
+	slots[id] = -1;
+	generations[id]++;
+	freeIds.push_back(id);
+
+	if (storage == structOfArrays) {
+		arrays.swapRemove(i);
+		return;
+	}
+	if (i != sprites.size() - 1) {
+		std::swap(sprites[i], sprites.back());
+	}
+	recycled.push_back(std::move(sprites.back()));
+	sprites.pop_back();
 }
 
+//  Order for the expiry heap: the soonest death on top
+//
+bool SpriteList::laterExpiry(const Expiry &a, const Expiry &b) {
+	return a.time > b.time;
+}
 
-//  Update the SpriteSystem by checking which sprites have exceeded their
-//  lifespan (and deleting).  Also the sprite is moved to it's next
-//  location based on velocity and direction.
+//  Remove the sprites whose lifespan is over at time now (ms), that is
+//  now is past birthtime + lifespan. Only the expired sprites and stale
+//  heap entries are touched. Returns how many sprites were removed.
 //
-void SpriteList::update() {
+int SpriteList::expire(float now) {
+	int n = 0;
+	while (expiries.size() > 0 && now - expiries[0].time > 0) {
+		Expiry e = expiries[0];
+		pop_heap(expiries.begin(), expiries.end(), laterExpiry);
+		expiries.pop_back();
+		if (slots[e.id] != -1 && generations[e.id] == e.generation) {
+			remove(slots[e.id]);
+			n++;
+		}
+	}
+	return n;
+}
 
-	if (sprites.size() == 0) return;
-	vector<Sprite>::iterator s = sprites.begin();
-	vector<Sprite>::iterator tmp;
+//  Remove every sprite and start the stats over. The sprites are kept for
+//  reuse like remove() does, so a restarted game doesn't allocate them again.
+//
+void SpriteList::clear() {
+	while (size() > 0) {
+		remove(size() - 1);
+	}
+	arrays.clear();
+	expiries.clear();
+	stats = PoolStats();
+	drawCalls = 0;
+}
 
-	// check which sprites have exceed their lifespan and delete
-	// from list.  When deleting multiple objects from a vector while
-	// traversing at the same time, use an iterator.
-	//
-	while (s != sprites.end()) {
-		if (s->lifespan != -1 && s->age() > s->lifespan) {
-			//			cout << "deleting sprite: " << s->name << endl;
-			tmp = sprites.erase(s);
-			s = tmp;
+//  Number of live sprites in either storage mode
+//
+int SpriteList::size() {
+	if (storage == structOfArrays) return arrays.size();
+	return sprites.size();
+}
+
+//  Switch storage mode, moving any live sprites over to the new storage
+//
+void SpriteList::setStorage(spriteStorage mode) {
+	if (mode == storage) return;
+	if (mode == structOfArrays) {
+		arrays.clear();
+		arrays.reserve(sprites.size());
+		for (int i = 0; i < sprites.size(); i++) {
+			arrays.push(sprites[i]);
 		}
-		else s++;
+		sprites.clear();
+	}
+	else {
+		sprites.clear();
+		sprites.reserve(arrays.size());
+		for (int i = 0; i < arrays.size(); i++) {
+			Sprite s = archetype;
+			arrays.read(i, s);
+			sprites.push_back(s);
+		}
+		arrays.clear();
+	}
+	storage = mode;
+}
+
+//  Get a full Sprite (archetype plus state) for sprite i, so the regular
+//  Sprite methods can be used on it. Changes are only kept after store().
+//
+Sprite SpriteList::load(int i) {
+	if (storage == arrayOfSprites) return sprites[i];
+	Sprite s = archetype;
+	arrays.read(i, s);
+	return s;
+}
+
+void SpriteList::store(int i, const Sprite &s) {
+	if (storage == arrayOfSprites) {
+		sprites[i] = s;
+		return;
 	}
+	arrays.write(i, s);
+}
 
+
+//  Update the SpriteSystem by removing the sprites that have exceeded their
+//  lifespan (see expire).  Also the sprite is moved to it's next
+//  location based on velocity and direction.
+//
+void SpriteList::update(float now, float dt) {
+	expire(now);
+	if (storage == structOfArrays) {
+		for (int i = 0; i < arrays.size(); i++) {
+			arrays.pos[i] += arrays.velocity[i] * dt;
+		}
+		return;
+	}
 	//  Move sprite
 	//
 	for (int i = 0; i < sprites.size(); i++) {
-		sprites[i].pos += sprites[i].velocity / ofGetFrameRate();
+		sprites[i].pos += sprites[i].velocity * dt;
+	}
+}
+
+//  Remember the current state of every sprite as the previous step, so
+//  draw() can blend between steps. Sprites in structOfArrays storage
+//  have no previous state and are drawn where they are.
+//
+void SpriteList::savePrevious() {
+	for (int i = 0; i < sprites.size(); i++) {
+		sprites[i].savePrevious();
 	}
 }
 
-//  Render all the sprites
+//  Render all the sprites. alpha blends between the previous and the
+//  current simulation step (1 = current).
 //
-void SpriteList::draw() {
+void SpriteList::draw(float alpha) {
+	PROFILE_ZONE("SpriteList::draw");
+	drawCalls = 0;
+	if (bBatch) {
+		drawBatched(alpha);
+		return;
+	}
+	if (storage == structOfArrays) {
+		for (int i = 0; i < arrays.size(); i++) {
+			archetype.pos = arrays.pos[i];
+			archetype.rot = arrays.rot[i];
+			archetype.draw();
+			drawCalls++;
+		}
+		return;
+	}
 	for (int i = 0; i < sprites.size(); i++) {
-		sprites[i].draw();
+		sprites[i].draw(alpha);
+		drawCalls++;
+	}
+}
+
+//  Render all the sprites with one mesh for the image sprites and one for
+//  the triangle sprites. The meshes are rebuilt every frame from the sprite
+//  transforms. Only sprites that use the first image found go into the
+//  image mesh; any other image is drawn the normal way.
+//
+void SpriteList::drawBatched(float alpha) {
+	imageMesh.clear();
+	shapeMesh.clear();
+	ofImage *image = NULL;
+	for (int i = 0; i < size(); i++) {
+		Sprite *s = &archetype;
+		if (storage == structOfArrays) {
+			archetype.pos = arrays.pos[i];
+			archetype.rot = arrays.rot[i];
+			archetype.savePrevious();
+		}
+		else s = &sprites[i];
+
+		if (!s->bShowImage) {
+			addTriangle(*s, alpha);
+			continue;
+		}
+		if (image == NULL) image = s->spriteImage;
+		if (s->spriteImage == image) {
+			addQuad(*s, alpha);
+		}
+		else {
+			s->draw(alpha);
+			drawCalls++;
+		}
+	}
+	if (shapeMesh.getNumVertices() > 0) {
+		shapeMesh.draw();
+		drawCalls++;
+	}
+	if (imageMesh.getNumVertices() > 0) {
+		ofSetColor(ofColor::white);
+		image->getTexture().bind();
+		imageMesh.draw();
+		image->getTexture().unbind();
+		drawCalls++;
+	}
+}
+
+//  Add the image rectangle of a sprite as two triangles, same placement
+//  as Sprite::draw (image centered on the sprite)
+//
+void SpriteList::addQuad(Sprite &s, float alpha) {
+	glm::mat4 m = s.getTransform(alpha);
+	ofTexture &tex = s.spriteImage->getTexture();
+	float w = s.spriteImage->getWidth();
+	float h = s.spriteImage->getHeight();
+	glm::vec3 corners[4] = {
+		m * glm::vec4(-w / 2, -h / 2, 0, 1),
+		m * glm::vec4(w / 2, -h / 2, 0, 1),
+		m * glm::vec4(w / 2, h / 2, 0, 1),
+		m * glm::vec4(-w / 2, h / 2, 0, 1)
+	};
+	glm::vec2 coords[4] = {
+		tex.getCoordFromPoint(0, 0),
+		tex.getCoordFromPoint(w, 0),
+		tex.getCoordFromPoint(w, h),
+		tex.getCoordFromPoint(0, h)
+	};
+	int order[6] = { 0, 1, 2, 0, 2, 3 };
+	for (int i = 0; i < 6; i++) {
+		imageMesh.addVertex(corners[order[i]]);
+		imageMesh.addTexCoord(coords[order[i]]);
+	}
+}
+
+//  Add the default triangle of a sprite, colored the same as Sprite::draw
+//
+void SpriteList::addTriangle(Sprite &s, float alpha) {
+	glm::mat4 m = s.getTransform(alpha);
+	ofFloatColor color = s.bHighlight ? ofColor::white : ofColor::green;
+	for (int i = 0; i < 3; i++) {
+		shapeMesh.addVertex(m * glm::vec4(s.verts[i], 1));
+		shapeMesh.addColor(color);
 	}
 }
 
 Emitter::Emitter() {
+	world = NULL;
+	jobs = NULL;
+	jobChunk = 256;
 	sys = new SpriteList();
 	init();
 }
 
+Emitter::~Emitter() {
+	delete sys;
+}
+
+//  Put the emitter back the way it was constructed, but keep its sprite
+//  list (with the pooled sprites), capacity, storage and job system
+//
+void Emitter::reset() {
+	init();
+	sys->clear();
+	pos = glm::vec3(0, 0, 0);
+	rot = 0;
+	scale = glm::vec3(1, 1, 1);
+	savePrevious();
+	bExplosion = false;
+	bBeam = false;
+	bEngine = false;
+}
+
 void Emitter::init() {
 	lifespan = 3000;    // default milliseconds
 	started = false;
+	bSpawnByRate = true;
 
 	lastSpawned = 0;
 	rate = 1;    // sprites/sec
 	haveChildImage = false;
 	haveImage = false;
+	childImage = NULL;
+	childMask = NULL;
+	image = NULL;
 	velocity = ofVec3f(100, 100, 0);
 	drawable = true;
 	width = 50;
@@ -107,7 +415,7 @@ void Emitter::init() {
 //  Draw the Emitter if it is drawable. In many cases you would want a hidden emitter
 //
 //
-void Emitter::draw() {
+void Emitter::draw(float alpha) {
 
 	// draw the Emitter itself 
 	// note: set drawable=false if you want the emitter to be invisible
@@ -118,7 +426,7 @@ void Emitter::draw() {
 		ofMultMatrix(getTransform());
 
 		if (haveImage) {
-			image.draw(-image.getWidth() / 2.0, -image.getHeight() / 2.0);
+			image->draw(-image->getWidth() / 2.0, -image->getHeight() / 2.0);
 		}
 		else {
 			// draw some default shape (square) if drawable but no image attached.
@@ -130,18 +438,18 @@ void Emitter::draw() {
 	}
 	// draw sprite system
 	//
-	sys->draw();
+	sys->draw(alpha);
 }
 
 //  Update the Emitter. If it has been started, spawn new sprites with
-//  initial velocity, lifespan, birthtime.
+//  initial velocity, lifespan, birthtime, then move the sprites dt seconds.
 //
-void Emitter::update() {
+void Emitter::update(float dt) {
 	if (!started) return;
-	float time = ofGetElapsedTimeMillis();
+	float time = world->time();
 	switch (emitterType) {
 	case enemySpawner:
-		if ((time - lastSpawned) > (1000.0 / rate)) {
+		if (bSpawnByRate && (time - lastSpawned) > (1000.0 / rate)) {
 			// call virtual to spawn a new sprite
 			//
 			spawnSprite();
@@ -152,33 +460,40 @@ void Emitter::update() {
 		break;
 	}
 
-	// update sprite list
+	// remove the sprites that have exceeded their lifespan, then move the
+	// rest
 	//
-	if (sys->sprites.size() == 0) return;
-	vector<Sprite>::iterator s = sys->sprites.begin();
-	vector<Sprite>::iterator tmp;
+	sys->expire(time);
+	if (sys->size() == 0) return;
+	moveSprites(dt);
+}
 
-	// check which sprites have exceed their lifespan and delete
-	// from list.  When deleting multiple objects from a vector while
-	// traversing at the same time, use an iterator.
-	//
-	while (s != sys->sprites.end()) {
-		if (s->lifespan != -1 && s->age() > s->lifespan) {
-			//			cout << "deleting sprite: " << s->name << endl;
-			tmp = sys->sprites.erase(s);
-			s = tmp;
-		}
-		else s++;
-	}
-	for (int i = 0; i < sys->sprites.size(); i++) {
-		moveSprite(&sys->sprites[i]);
+// virtual function to move all sprites (can be overloaded). In structOfArrays
+// mode the default straight line motion runs directly on the arrays.
+// Each sprite only touches its own state, so the sprites can be moved in
+// parallel chunks (see forEachChunk).
+//
+void Emitter::moveSprites(float dt) {
+	if (sys->storage == structOfArrays) {
+		SpriteArrays &a = sys->arrays;
+		forEachChunk(a.size(), [&](int begin, int end) {
+			for (int i = begin; i < end; i++) {
+				a.pos[i] += a.velocity[i] * dt;
+			}
+		});
+		return;
 	}
+	forEachChunk(sys->sprites.size(), [&](int begin, int end) {
+		for (int i = begin; i < end; i++) {
+			moveSprite(&sys->sprites[i], dt);
+		}
+	});
 }
 
 // virtual function to move sprite (can be overloaded)
 //
-void Emitter::moveSprite(Sprite *sprite) {
-    sprite->pos += sprite->velocity / ofGetFrameRate();
+void Emitter::moveSprite(Sprite *sprite, float dt) {
+    sprite->pos += sprite->velocity * dt;
 	//sprite->rot += sprite->rotationSpeed;
 }
 
@@ -186,21 +501,38 @@ void Emitter::moveSprite(Sprite *sprite) {
 //
 void Emitter::spawnSprite() {
 	for (int i = 0; i < nAgents; i++) {
-		Sprite sprite;
-		if (haveChildImage) sprite.setImage(childImage);
+		Sprite &sprite = spawned;
+		sprite.reset();
+		if (haveChildImage) sprite.setImage(childImage, childMask);
 		sprite.velocity = velocity;
 		sprite.lifespan = lifespan;
 		sprite.pos = pos;
-		sprite.birthtime = ofGetElapsedTimeMillis();
+		sprite.birthtime = world->time();
 		sys->add(sprite);
 	}
 }
 
+// virtual function to spawn a burst of a wave (can be overloaded). The
+// sprite is set up once and only the position changes between copies.
+//
+void Emitter::spawnBurst(const SpawnEvent &e) {
+	Sprite &sprite = spawned;
+	sprite.reset();
+	if (haveChildImage) sprite.setImage(childImage, childMask);
+	sprite.velocity = e.velocity;
+	sprite.lifespan = e.lifespan;
+	sprite.birthtime = world->time();
+	for (int i = 0; i < e.count; i++) {
+		sprite.pos = glm::vec3(world->random(e.x, e.x + e.w) * world->width, world->random(e.y, e.y + e.h) * world->height, 0);
+		if (!sys->add(sprite)) break;
+	}
+}
+
 // Start/Stop the emitter.
 //
 void Emitter::start() {
 	started = true;
-	lastSpawned = ofGetElapsedTimeMillis();
+	lastSpawned = world->time();
 }
 
 void Emitter::stop() {
@@ -216,12 +548,14 @@ void Emitter::setVelocity(const glm::vec3 v) {
 	velocity = v;
 }
 
-void Emitter::setChildImage(ofImage img) {
+void Emitter::setChildImage(ofImage *img, AlphaMask *mask) {
 	childImage = img;
+	childMask = mask;
 	haveChildImage = true;
+	sys->archetype.setImage(img, mask);
 }
 
-void Emitter::setImage(ofImage img) {
+void Emitter::setImage(ofImage *img) {
 	image = img;
 	haveImage = true;
 }
@@ -232,3 +566,15 @@ void Emitter::setRate(float r) {
 void Emitter::setNAgents(int nAgents) {
 	this->nAgents = nAgents;
 }
+
+// Set the size of the sprite pool (see SpriteList)
+//
+void Emitter::setCapacity(int n) {
+	sys->setCapacity(n);
+}
+
+// Switch how the sprite list stores its sprites (see SpriteList)
+//
+void Emitter::setStorage(spriteStorage storage) {
+	sys->setStorage(storage);
+}
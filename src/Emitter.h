@@ -3,17 +3,130 @@
 #include "ofMain.h"
 #include "Shape.h"
 #include "Sprite.h"
+#include "SpriteArrays.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include "WaveSchedule.h"
+
+class World;
+
+enum spriteStorage {
+	arrayOfSprites,
+	structOfArrays
+};
+
+// Counters for the sprite pool in a SpriteList
+//
+struct PoolStats {
+	int nAllocated = 0;   // sprites that had to be constructed
+	int nReused = 0;      // allocations avoided by reusing a released sprite
+	int peak = 0;         // most sprites alive at once
+	int nExhausted = 0;   // spawns dropped because the pool was full
+};
+
+//  Values that every sprite in a list shares. The World's systems apply
+//  them to all the sprites each step (see World::runSystems), and add()
+//  applies the style to each new sprite so it is right from its first step.
+//  The style is only written to the live sprites after setStyle changed it.
+//
+struct SpriteRules {
+	bool bStyle = false;        // set scale and rotationSpeed on the sprites
+	float scale = 1;
+	float rotationSpeed = 0;
+	bool bChanged = false;      // style changed since it was last applied
+	bool bBounce = false;       // bounce off the arena border
+
+	void setStyle(float scale, float rotationSpeed) {
+		bChanged |= !bStyle || scale != this->scale || rotationSpeed != this->rotationSpeed;
+		bStyle = true;
+		this->scale = scale;
+		this->rotationSpeed = rotationSpeed;
+	}
+	void style(Sprite &s) {
+		s.scale = glm::vec3(scale, scale, scale);
+		s.rotationSpeed = rotationSpeed;
+	}
+};
 
 //
 //  Manages all Sprites in a system.  You can create multiple systems
 //
+//  By default each sprite is a full Sprite in "sprites". In structOfArrays
+//  mode the per-sprite state is kept in "arrays" and the image, name, scale
+//  and verts are shared through "archetype". Use load/store to get a Sprite
+//  back out of the arrays when you need the regular Sprite methods.
+//
+//  structOfArrays is for the benchmarks only: the World's collisions,
+//  shared systems and interpolated drawing only read "sprites", and
+//  switching storage drops the pooled sprites and the lifetimes, so
+//  World::setup and World::step assert that the game's lists use
+//  arrayOfSprites.
+//
+//  The list is also a fixed-capacity pool: removing a sprite swaps the last
+//  sprite into its slot and keeps the removed one in "recycled", and add()
+//  reuses a recycled sprite before constructing a new one.  Removing does
+//  not keep the order of the sprites.
+//
+//  Lifetimes are kept in a min-heap of death times (birthtime + lifespan,
+//  taken when the sprite is added), so expire() only looks at the sprites
+//  that die, not at every sprite. Each sprite has an id that stays the
+//  same while it moves between slots; a heap entry of a sprite that was
+//  removed early is skipped when it comes up. A lifespan changed after
+//  add() is not seen by expire().
+//
+//  "rules" are the values shared by every sprite in the list (see
+//  SpriteRules).
+//
+//  With bBatch set, draw() puts all image sprites into one textured mesh
+//  and all triangle sprites into another, so the list is drawn with one
+//  draw call per mesh instead of one per sprite.
+//
 class SpriteList {
 public:
-	void add(Sprite);
+	SpriteList();
+	bool add(const Sprite &);
 	void remove(int);
-	void update();
-	void draw();
+	void setCapacity(int);
+	void preallocate(int);
+	void clear();
+	int expire(float now);
+	void update(float now, float dt);
+	void draw(float alpha = 1.0);
+	void drawBatched(float alpha);
+	void savePrevious();
+	int size();
+	void setStorage(spriteStorage);
+	Sprite load(int);
+	void store(int, const Sprite &);
 	vector<Sprite> sprites;
+	vector<Sprite> recycled;
+	int capacity;
+	PoolStats stats;
+
+	spriteStorage storage;
+	SpriteArrays arrays;
+	Sprite archetype;
+	SpriteRules rules;
+
+	bool bBatch;
+	int drawCalls;      // draw calls made by the last draw()
+
+private:
+	struct Expiry {
+		float time;     // birthtime + lifespan
+		int id;
+		uint32_t generation;
+	};
+	vector<Expiry> expiries;        // min-heap on time
+	vector<int> ids;                // ids[slot] = id of the sprite in slot
+	vector<int> slots;              // slots[id] = slot, -1 if the id is free
+	vector<uint32_t> generations;   // bumped each time an id is freed
+	vector<int> freeIds;
+	void addQuad(Sprite &s, float alpha);
+	void addTriangle(Sprite &s, float alpha);
+	static bool laterExpiry(const Expiry &a, const Expiry &b);
+	ofVboMesh imageMesh;
+	ofVboMesh shapeMesh;
 };
 
 enum emitterType {
@@ -27,39 +140,62 @@ enum emitterType {
 class Emitter : public Shape {
 public:
 	Emitter();
+	virtual ~Emitter();
 	void init();
-	void draw();
+	void reset();
+	void draw(float alpha = 1.0);
 	void start();
 	void stop();
 	void setLifespan(float);
 	void setVelocity(const glm::vec3 v);
-	void setChildImage(ofImage);
-	void setImage(ofImage);
+	void setChildImage(ofImage *, AlphaMask *mask = NULL);
+	void setImage(ofImage *);
 	void setRate(float);
 	void setNAgents(int);
-	void update();
+	void setStorage(spriteStorage);
+	void setCapacity(int);
+	void update(float dt);
 	
 
 	// virtuals - can overloaded
-	virtual void moveSprite(Sprite *);
+	virtual void moveSprite(Sprite *, float dt);
+	virtual void moveSprites(float dt);
+
+	// Run fn(begin, end) over [0, count) in chunks of jobChunk on the job
+	// system, or in one go on this thread if there is none. Spawning and
+	// removing sprites must stay outside fn. fn is passed by reference, so
+	// the lambda isn't copied into a heap allocated std::function.
+	//
+	template <class F>
+	void forEachChunk(int count, F fn) {
+		if (jobs) jobs->parallelFor(count, jobChunk, std::ref(fn));
+		else fn(0, count);
+	}
 	virtual void spawnSprite();
+	virtual void spawnBurst(const SpawnEvent &e);
 	virtual bool insidePoint(glm::vec3 p) {
-		glm::vec3 s = glm::inverse(getTransform()) * glm::vec4(p, 1);
+		glm::vec3 s = toObject(p);
 		return (s.x > -width / 2 && s.x < width / 2 && s.y > -height / 2 && s.y < height / 2);
 	}
 
+	World *world;       // clock, random numbers and player for this emitter
+	JobSystem *jobs;    // if set, sprites are moved in parallel chunks
+	int jobChunk;       // sprites per chunk, a multiple of the SIMD width
 	SpriteList *sys;
 	float rate;
 	glm::vec3 velocity;
 	float lifespan;
 	bool started;
+	bool bSpawnByRate;  // enemySpawner spawns every 1/rate sec, else only when told
 	float lastSpawned;
-	ofImage childImage;
-	ofImage image;
+	ofImage *childImage;
+	AlphaMask *childMask;
+	ofImage *image;
 	bool drawable;
 	bool haveChildImage;
 	bool haveImage;
 	float width, height;
 	int nAgents;
 	emitterType emitterType;
+	Sprite spawned;     // reused by spawnSprite to build each new sprite
 };
\ No newline at end of file
@@ -0,0 +1,65 @@
+#include "FrameArena.h"
+
+FrameArena::FrameArena(size_t bytes) {
+	capacity = bytes;
+	buffer = (char *)malloc(capacity);
+	top = 0;
+	used = 0;
+	peak = 0;
+	nOverflows = 0;
+}
+
+FrameArena::~FrameArena() {
+	reset();
+	free(buffer);
+}
+
+//  bytes of scratch memory aligned to align (a power of two), valid until
+//  the next reset()
+//
+void *FrameArena::alloc(size_t bytes, size_t align) {
+	size_t start = (top + align - 1) & ~(align - 1);
+	used += bytes;
+	peak = MAX(peak, used);
+	if (start + bytes <= capacity) {
+		top = start + bytes;
+		return buffer + start;
+	}
+	void *p = malloc(bytes);
+	overflow.push_back(p);
+	nOverflows++;
+	return p;
+}
+
+//  Resize an allocation to newBytes, keeping its first oldBytes. The last
+//  allocation in the buffer is extended in place if there is room,
+//  anything else is copied to a new allocation. p may be NULL.
+//
+void *FrameArena::grow(void *p, size_t oldBytes, size_t newBytes, size_t align) {
+	if (p != NULL && (char *)p + oldBytes == buffer + top && (char *)p - buffer + newBytes <= capacity) {
+		top += newBytes - oldBytes;
+		used += newBytes - oldBytes;
+		peak = MAX(peak, used);
+		return p;
+	}
+	void *q = alloc(newBytes, align);
+	if (p != NULL) memcpy(q, p, oldBytes);
+	return q;
+}
+
+//  Free everything handed out since the last reset. If the buffer was too
+//  small, replace it with one that fits the busiest step so far.
+//
+void FrameArena::reset() {
+	if (!overflow.empty()) {
+		for (int i = 0; i < overflow.size(); i++) {
+			free(overflow[i]);
+		}
+		overflow.clear();
+		free(buffer);
+		capacity = MAX(capacity * 2, peak * 2);
+		buffer = (char *)malloc(capacity);
+	}
+	top = 0;
+	used = 0;
+}
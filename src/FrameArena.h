@@ -0,0 +1,66 @@
+#pragma once
+
+#include "ofMain.h"
+
+//  Bump allocator for scratch memory that only lives for one step of the
+//  World. alloc() just moves a pointer along one buffer, and reset() (at
+//  the end of every step) frees everything at once.
+//
+//  If a step needs more than the buffer holds, the extra comes from the
+//  heap and is freed at reset, which then grows the buffer to fit, so only
+//  the first busy steps allocate.
+//
+class FrameArena {
+public:
+	FrameArena(size_t bytes = 64 * 1024);
+	~FrameArena();
+	void *alloc(size_t bytes, size_t align = 16);
+	void *grow(void *p, size_t oldBytes, size_t newBytes, size_t align = 16);
+	void reset();
+
+	size_t used;            // bytes handed out this step
+	size_t peak;            // most bytes used in one step
+	int nOverflows;         // heap blocks needed because the buffer was full
+
+private:
+	char *buffer;
+	size_t capacity;
+	size_t top;             // end of the last allocation in buffer
+	vector<void *> overflow;
+};
+
+//  Growable array of trivially copyable items whose storage comes from a
+//  FrameArena. Growing extends the array in place when it is the last
+//  thing allocated. clear() must be called when the arena is reset.
+//
+template <class T>
+class FrameVector {
+public:
+	static_assert(std::is_trivially_copyable<T>::value, "FrameVector items are moved with memcpy");
+
+	void setArena(FrameArena *arena) { this->arena = arena; }
+	void clear() {
+		items = NULL;
+		n = 0;
+		capacity = 0;
+	}
+	void push_back(const T &item) {
+		if (n == capacity) {
+			int more = MAX(64, capacity * 2);
+			items = (T *)arena->grow(items, capacity * sizeof(T), more * sizeof(T), alignof(T));
+			capacity = more;
+		}
+		items[n++] = item;
+	}
+	void resize(int size) { n = MIN(size, capacity); }
+	int size() const { return n; }
+	T &operator[](int i) { return items[i]; }
+	T *begin() { return items; }
+	T *end() { return items + n; }
+
+private:
+	FrameArena *arena = NULL;
+	T *items = NULL;
+	int n = 0;
+	int capacity = 0;
+};
@@ -0,0 +1,76 @@
+#include "ImageRegistry.h"
+
+//  Return the image for path, loading it the first time it is asked for.
+//  Returns NULL if the file can't be loaded.
+//
+ofImage *ImageRegistry::load(string path) {
+	map<string, ofImage>::iterator it = images.find(path);
+	if (it != images.end()) return &it->second;
+
+	ofImage img;
+	img.setUseTexture(bUseTexture);
+	if (!img.load(path)) return NULL;
+	images[path] = img;
+	ofImage *loaded = &images[path];
+	masks[loaded].build(*loaded);
+	return loaded;
+}
+
+//  Add an image decoded elsewhere (see AssetLoader) with its mask. This
+//  uploads the texture, so call it on the GL thread.
+//
+ofImage *ImageRegistry::add(string path, ofPixels &pixels, AlphaMask &mask) {
+	ofImage &img = images[path];
+	img.setUseTexture(bUseTexture);
+	img.setFromPixels(pixels);
+	masks[&img] = mask;
+	return &img;
+}
+
+//  The image loaded for path, NULL if it hasn't been loaded
+//
+ofImage *ImageRegistry::find(string path) {
+	map<string, ofImage>::iterator it = images.find(path);
+	if (it == images.end()) return NULL;
+	return &it->second;
+}
+
+//  The alpha mask of an image returned by load(), NULL for other images
+//
+AlphaMask *ImageRegistry::getMask(ofImage *img) {
+	map<ofImage *, AlphaMask>::iterator it = masks.find(img);
+	if (it == masks.end()) return NULL;
+	return &it->second;
+}
+
+//  The path an image was loaded from, "" for other images
+//
+string ImageRegistry::pathOf(ofImage *img) {
+	map<string, ofImage>::iterator it;
+	for (it = images.begin(); it != images.end(); it++) {
+		if (&it->second == img) return it->first;
+	}
+	return "";
+}
+
+int ImageRegistry::size() {
+	return images.size();
+}
+
+//  Memory held by the loaded images: the pixels in RAM plus, if the image
+//  has been uploaded, a texture of the same size on the GPU, plus the masks.
+//
+size_t ImageRegistry::residentBytes() {
+	size_t bytes = 0;
+	map<string, ofImage>::iterator it;
+	for (it = images.begin(); it != images.end(); it++) {
+		size_t n = it->second.getPixels().size();
+		bytes += n;
+		if (it->second.isUsingTexture()) bytes += n;
+	}
+	map<ofImage *, AlphaMask>::iterator m;
+	for (m = masks.begin(); m != masks.end(); m++) {
+		bytes += m->second.bytes();
+	}
+	return bytes;
+}
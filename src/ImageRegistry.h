@@ -0,0 +1,25 @@
+#pragma once
+
+#include "ofMain.h"
+#include "AlphaMask.h"
+
+//  Loads each image file once and hands out pointers to the shared copy.
+//  Sprites and emitters only keep the pointer, so spawning a sprite no
+//  longer copies the image.  The images live as long as the registry.
+//  An AlphaMask is built for each image when it is loaded.  Images can
+//  also be decoded on another thread and added with add() (AssetLoader).
+//
+class ImageRegistry {
+public:
+	ofImage *load(string path);
+	ofImage *add(string path, ofPixels &pixels, AlphaMask &mask);
+	ofImage *find(string path);
+	AlphaMask *getMask(ofImage *img);
+	string pathOf(ofImage *img);
+	int size();
+	size_t residentBytes();
+
+	map<string, ofImage> images;
+	map<ofImage *, AlphaMask> masks;
+	bool bUseTexture = true;    // false to load pixels only (no GL context)
+};
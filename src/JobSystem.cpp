@@ -0,0 +1,132 @@
+#include "JobSystem.h"
+
+JobSystem::JobSystem() {
+	pending = 0;
+	generation = 0;
+	quit = false;
+}
+
+JobSystem::~JobSystem() {
+	stop();
+}
+
+//  Start nThreads - 1 worker threads (the caller of parallelFor is the
+//  other one). 0 means one thread per hardware thread. Does nothing if
+//  that many are already running.
+//
+void JobSystem::start(int nThreads) {
+	if (nThreads <= 0) nThreads = MAX(1, int(std::thread::hardware_concurrency()));
+	if (nThreads == queues.size()) return;     // already running
+	stop();
+	quit = false;
+	for (int i = 0; i < nThreads; i++) {
+		queues.push_back(new Queue());
+	}
+	for (int i = 1; i < nThreads; i++) {
+		workers.push_back(std::thread(&JobSystem::workerLoop, this, i));
+	}
+}
+
+void JobSystem::stop() {
+	{
+		std::lock_guard<std::mutex> lock(wakeMutex);
+		quit = true;
+	}
+	wake.notify_all();
+	for (int i = 0; i < workers.size(); i++) {
+		workers[i].join();
+	}
+	workers.clear();
+	for (int i = 0; i < queues.size(); i++) {
+		delete queues[i];
+	}
+	queues.clear();
+}
+
+int JobSystem::size() {
+	return MAX(1, int(queues.size()));
+}
+
+//  Run fn(begin, end) over [0, count) in chunks of chunkSize. The chunks
+//  are dealt out to the queues round robin before the workers are woken.
+//  fn is copied, pass std::ref(lambda) to keep that from allocating.
+//
+void JobSystem::parallelFor(int count, int chunkSize, const std::function<void(int begin, int end)> &fn) {
+	if (count <= 0) return;
+	int nChunks = (count + chunkSize - 1) / chunkSize;
+	if (size() == 1 || nChunks == 1) {
+		fn(0, count);
+		return;
+	}
+
+	task = fn;
+	pending = nChunks;
+	for (int c = 0; c < nChunks; c++) {
+		Job job;
+		job.begin = c * chunkSize;
+		job.end = MIN(count, job.begin + chunkSize);
+		Queue *q = queues[c % queues.size()];
+		std::lock_guard<std::mutex> lock(q->mutex);
+		q->jobs.push_back(job);
+	}
+	{
+		std::lock_guard<std::mutex> lock(wakeMutex);
+		generation++;
+	}
+	wake.notify_all();
+
+	// help out until every chunk is done
+	//
+	while (pending > 0) {
+		if (!runOne(0)) std::this_thread::yield();
+	}
+}
+
+//  Run one chunk: from the back of our own queue, or stolen from the front
+//  of another queue. Returns false if there was nothing to run.
+//
+bool JobSystem::runOne(int index) {
+	Job job;
+	bool found = false;
+	{
+		Queue *q = queues[index];
+		std::lock_guard<std::mutex> lock(q->mutex);
+		if (q->head < q->jobs.size()) {
+			job = q->jobs.back();
+			q->jobs.pop_back();
+			found = true;
+		}
+		if (q->head == q->jobs.size()) {
+			q->jobs.clear();
+			q->head = 0;
+		}
+	}
+	for (int i = 1; i < queues.size() && !found; i++) {
+		Queue *q = queues[(index + i) % queues.size()];
+		std::lock_guard<std::mutex> lock(q->mutex);
+		if (q->head < q->jobs.size()) {
+			job = q->jobs[q->head++];
+			found = true;
+		}
+	}
+	if (!found) return false;
+	task(job.begin, job.end);
+	pending--;
+	return true;
+}
+
+//  Workers sleep until parallelFor deals out a new batch, then run chunks
+//  until there are none left to run or steal
+//
+void JobSystem::workerLoop(int index) {
+	int seen = 0;
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(wakeMutex);
+			wake.wait(lock, [&]() { return quit || generation != seen; });
+			if (quit) return;
+			seen = generation;
+		}
+		while (runOne(index)) {}
+	}
+}
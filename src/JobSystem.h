@@ -0,0 +1,50 @@
+#pragma once
+
+#include "ofMain.h"
+
+//  Small thread pool for splitting a loop over sprites into chunks.
+//
+//  Every thread (the workers and the thread calling parallelFor) has its own
+//  queue of chunks. A thread takes chunks from the back of its own queue,
+//  and when that runs out it steals from the front of another thread's
+//  queue, so a thread that finishes early helps the others.  parallelFor
+//  returns when all chunks are done.
+//
+//  With 1 thread (or before start) parallelFor just runs the loop on the
+//  calling thread.
+//
+class JobSystem {
+public:
+	JobSystem();
+	~JobSystem();
+	void start(int nThreads = 0);
+	void stop();
+	int size();
+	void parallelFor(int count, int chunkSize, const std::function<void(int begin, int end)> &fn);
+
+private:
+	struct Job {
+		int begin;
+		int end;
+	};
+	// jobs[head..] are left; the owner takes from the back, thieves take
+	// jobs[head]. The vector keeps its capacity, so dealing out chunks
+	// doesn't allocate after the first time.
+	struct Queue {
+		std::mutex mutex;
+		vector<Job> jobs;
+		int head = 0;
+	};
+
+	void workerLoop(int index);
+	bool runOne(int index);
+
+	vector<std::thread> workers;
+	vector<Queue *> queues;     // queues[0] belongs to the calling thread
+	std::function<void(int, int)> task;
+	std::atomic<int> pending;
+	std::mutex wakeMutex;
+	std::condition_variable wake;
+	int generation;
+	bool quit;
+};
@@ -0,0 +1,125 @@
+#include "ParticleBuffer.h"
+
+ParticleBuffer::ParticleBuffer(int capacity) {
+	mesh.setMode(OF_PRIMITIVE_TRIANGLES);
+	mesh.setUsage(GL_STREAM_DRAW);
+	setCapacity(capacity);
+}
+
+//  Set the most particles alive at once. The arrays are sized up front, so
+//  adding never allocates. Drops the live particles.
+//
+void ParticleBuffer::setCapacity(int n) {
+	capacity = MAX(n, 1);
+	x.resize(capacity);
+	y.resize(capacity);
+	vx.resize(capacity);
+	vy.resize(capacity);
+	birthtime.resize(capacity);
+	color.resize(capacity);
+	clear();
+}
+
+void ParticleBuffer::clear() {
+	head = 0;
+	count = 0;
+	nOverwritten = 0;
+	drawCalls = 0;
+}
+
+int ParticleBuffer::size() {
+	return count;
+}
+
+int ParticleBuffer::slot(int i) {
+	return (head - count + i + capacity) % capacity;
+}
+
+//  Add a particle born at now (ms). If the ring is full this takes the
+//  place of the oldest particle.
+//
+void ParticleBuffer::add(glm::vec3 pos, glm::vec3 velocity, float now, ofFloatColor c) {
+	x[head] = pos.x;
+	y[head] = pos.y;
+	vx[head] = velocity.x;
+	vy[head] = velocity.y;
+	birthtime[head] = now;
+	color[head] = c;
+	head = (head + 1) % capacity;
+	if (count < capacity) count++;
+	else nOverwritten++;
+}
+
+//  Run fn(begin, end) over the live particles, which are one or two
+//  contiguous ranges of the arrays depending on where the ring wraps
+//
+template <class F>
+void ParticleBuffer::forEachSpan(F fn) {
+	int tail = slot(0);
+	if (tail + count <= capacity) {
+		fn(tail, tail + count);
+	}
+	else {
+		fn(tail, capacity);
+		fn(0, head);
+	}
+}
+
+//  Drop the particles older than lifespan at time now (ms), then move the
+//  rest dt seconds and slow them down
+//
+void ParticleBuffer::update(float now, float dt) {
+	PROFILE_ZONE("ParticleBuffer::update");
+	while (count > 0 && now - birthtime[slot(0)] > lifespan) {
+		count--;
+	}
+	lastTime = now;
+	lastDt = dt;
+
+	float *px = x.data();
+	float *py = y.data();
+	float *pvx = vx.data();
+	float *pvy = vy.data();
+	float d = damping;
+	forEachSpan([&](int begin, int end) {
+		for (int i = begin; i < end; i++) {
+			px[i] += pvx[i] * dt;
+			py[i] += pvy[i] * dt;
+			pvx[i] *= d;
+			pvy[i] *= d;
+		}
+	});
+}
+
+//  Draw every particle as a small triangle in one mesh, faded out over
+//  its lifespan. alpha blends between the previous and the current step
+//  like SpriteList::draw, by stepping back along the velocity. Particles
+//  added since the last update haven't moved yet and have no previous
+//  step, so they are drawn where they were spawned.
+//
+void ParticleBuffer::draw(float alpha) {
+	PROFILE_ZONE("ParticleBuffer::draw");
+	drawCalls = 0;
+	mesh.clear();
+	if (count == 0) return;
+	float back = (alpha - 1) * lastDt / damping;
+	glm::vec3 corners[3] = {
+		glm::vec3(-radius, radius, 0),
+		glm::vec3(radius, radius, 0),
+		glm::vec3(0, -radius, 0)
+	};
+	forEachSpan([&](int begin, int end) {
+		for (int i = begin; i < end; i++) {
+			float b = birthtime[i] < lastTime ? back : 0;
+			glm::vec3 p(x[i] + vx[i] * b, y[i] + vy[i] * b, 0);
+			ofFloatColor c = color[i];
+			c.a *= ofClamp(1 - (lastTime - birthtime[i]) / lifespan, 0, 1);
+			for (int k = 0; k < 3; k++) {
+				mesh.addVertex(p + corners[k]);
+				mesh.addColor(c);
+			}
+		}
+	});
+	mesh.draw();
+	drawCalls++;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "ofMain.h"
+#include "Profiler.h"
+
+//  Lightweight particles for the explosions: only position, velocity,
+//  birth time and colour, kept in parallel arrays that are used as a ring
+//  buffer with a fixed capacity.  When it is full, add() writes over the
+//  oldest particle, so a step and a draw never cost more than the capacity
+//  however many enemies explode at once.
+//
+//  Every particle lives the same lifespan, so they die in the order they
+//  were added and expiring only moves the tail of the ring forward.  The
+//  update is plain loops over float arrays that the compiler can vectorise,
+//  and draw() puts every particle into one mesh for a single draw call.
+//
+class ParticleBuffer {
+public:
+	ParticleBuffer(int capacity = 2048);
+	void setCapacity(int n);
+	void clear();
+	void add(glm::vec3 pos, glm::vec3 velocity, float now, ofFloatColor color);
+	void update(float now, float dt);
+	void draw(float alpha = 1.0);
+	int size();
+	int slot(int i);        // index in the arrays of the i-th oldest particle
+
+	vector<float> x, y;
+	vector<float> vx, vy;   // px/sec
+	vector<float> birthtime;
+	vector<ofFloatColor> color;
+
+	float lifespan = 1000;  // ms
+	float damping = .96;    // velocity kept per step
+	float radius = 3;       // px, the particles are drawn as triangles
+	int nOverwritten = 0;   // live particles dropped because the ring was full
+	int drawCalls = 0;      // draw calls made by the last draw()
+
+private:
+	template <class F>
+	void forEachSpan(F fn);
+
+	int capacity;
+	int head = 0;           // where the next particle goes
+	int count = 0;
+	float lastTime = 0;     // now of the last update, for fading
+	float lastDt = 0;
+	ofVboMesh mesh;
+};
@@ -0,0 +1,123 @@
+#include "Profiler.h"
+#include <iomanip>
+
+Profiler &profiler() {
+	static Profiler p;
+	return p;
+}
+
+Profiler::Profiler() {
+	origin = std::chrono::steady_clock::now();
+}
+
+Profiler::~Profiler() {
+	for (int i = 0; i < rings.size(); i++) {
+		delete rings[i];
+	}
+}
+
+//  Microseconds since the profiler was created
+//
+double Profiler::now() {
+	return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - origin).count();
+}
+
+//  The calling thread's ring, made the first time the thread records
+//
+Profiler::Ring *Profiler::ring() {
+	static thread_local Ring *mine = NULL;
+	if (mine == NULL) {
+		mine = new Ring();
+		mine->written = 0;
+		std::lock_guard<std::mutex> lock(ringsMutex);
+		mine->thread = rings.size();
+		rings.push_back(mine);
+	}
+	return mine;
+}
+
+void Profiler::record(const char *name, double start, double end) {
+	if (!bEnabled) return;
+	Ring *r = ring();
+	uint64_t n = r->written.load(std::memory_order_relaxed);
+	ProfileEvent &e = r->events[n % ringSize];
+	e.name = name;
+	e.start = start;
+	e.end = end;
+	r->written.store(n + 1, std::memory_order_release);
+}
+
+//  Main thread: a new frame starts now
+//
+void Profiler::frame() {
+	frameStarts[frameCount % maxFrames] = now();
+	frameCount++;
+}
+
+//  min/avg/p99 of each zone over the events that started in the last
+//  nFrames frames (at most maxFrames), in microseconds, in order of the
+//  zone names. Without frame markers every event in the rings counts.
+//
+void Profiler::stats(vector<ZoneStats> &out, int nFrames) {
+	out.clear();
+	uint64_t frames = MIN(uint64_t(MAX(nFrames, 1)), MIN(frameCount, uint64_t(maxFrames)));
+	double since = frames > 0 ? frameStarts[(frameCount - frames) % maxFrames] : 0;
+
+	std::lock_guard<std::mutex> lock(ringsMutex);
+	zoneNames.clear();
+	for (int r = 0; r < rings.size(); r++) {
+		uint64_t n = MIN(rings[r]->written.load(std::memory_order_acquire), uint64_t(ringSize));
+		for (int i = 0; i < n; i++) {
+			ProfileEvent &e = rings[r]->events[i];
+			if (e.start < since) continue;
+			if (find(zoneNames.begin(), zoneNames.end(), e.name) == zoneNames.end()) zoneNames.push_back(e.name);
+		}
+	}
+	sort(zoneNames.begin(), zoneNames.end(), [](const char *a, const char *b) { return strcmp(a, b) < 0; });
+
+	for (int z = 0; z < zoneNames.size(); z++) {
+		durations.clear();
+		for (int r = 0; r < rings.size(); r++) {
+			uint64_t n = MIN(rings[r]->written.load(std::memory_order_acquire), uint64_t(ringSize));
+			for (int i = 0; i < n; i++) {
+				ProfileEvent &e = rings[r]->events[i];
+				if (e.name == zoneNames[z] && e.start >= since) durations.push_back(e.end - e.start);
+			}
+		}
+		sort(durations.begin(), durations.end());
+		ZoneStats s;
+		s.name = zoneNames[z];
+		s.count = durations.size();
+		s.min = durations[0];
+		double total = 0;
+		for (int i = 0; i < durations.size(); i++) total += durations[i];
+		s.avg = total / durations.size();
+		s.p99 = durations[(durations.size() - 1) * 99 / 100];
+		out.push_back(s);
+	}
+}
+
+//  Write the events in the rings as a Chrome trace (chrome://tracing or
+//  Perfetto), one complete ("X") event per zone, one track per thread
+//
+bool Profiler::writeTrace(string path) {
+	ofstream file(path);
+	if (!file) return false;
+	file << "{\"traceEvents\":[" << endl;
+	bool first = true;
+	std::lock_guard<std::mutex> lock(ringsMutex);
+	for (int r = 0; r < rings.size(); r++) {
+		uint64_t written = rings[r]->written.load(std::memory_order_acquire);
+		uint64_t begin = written > ringSize ? written - ringSize : 0;
+		for (uint64_t i = begin; i < written; i++) {
+			ProfileEvent &e = rings[r]->events[i % ringSize];
+			if (!first) file << "," << endl;
+			first = false;
+			file << "{\"name\":\"" << e.name << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << rings[r]->thread
+				<< ",\"ts\":" << std::fixed << std::setprecision(3) << e.start
+				<< ",\"dur\":" << e.end - e.start << "}";
+		}
+	}
+	file << endl << "]}" << endl;
+	return true;
+}
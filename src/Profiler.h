@@ -0,0 +1,91 @@
+#pragma once
+
+#include "ofMain.h"
+
+//  One timed zone, times in microseconds since the profiler started
+//
+struct ProfileEvent {
+	const char *name;
+	double start;
+	double end;
+};
+
+//  Rolling timings of one zone over the last frames (see Profiler::stats)
+//
+struct ZoneStats {
+	const char *name;
+	int count;
+	double min;
+	double avg;
+	double p99;
+};
+
+//  Frame profiler. A ProfileZone (see PROFILE_ZONE) records how long its
+//  scope took into a ring buffer of the thread it ran on, so a zone costs
+//  two clock reads and a store.  stats() and writeTrace() read every
+//  thread's ring without locking it, so call them from the main thread
+//  while the job system is idle (between frames).
+//
+//  frame() marks the start of each frame on the main thread, so stats()
+//  can cover the same last frames for every zone however often it fires.
+//
+//  Zone names must be string literals: events keep the pointer, and zones
+//  are told apart by it.
+//
+class Profiler {
+public:
+	static const int ringSize = 8192;
+	static const int maxFrames = 256;  // frame starts kept for stats()
+
+	struct Ring {
+		int thread;
+		std::atomic<uint64_t> written;      // events ever written
+		ProfileEvent events[ringSize];
+	};
+
+	Profiler();
+	~Profiler();
+	double now();
+	void record(const char *name, double start, double end);
+	void frame();
+	void stats(vector<ZoneStats> &out, int nFrames = 120);
+	bool writeTrace(string path);
+
+	bool bEnabled = true;
+
+private:
+	Ring *ring();
+
+	std::chrono::steady_clock::time_point origin;
+	std::mutex ringsMutex;
+	vector<Ring *> rings;
+	vector<const char *> zoneNames;     // stats() scratch, reused between calls
+	vector<double> durations;
+	double frameStarts[maxFrames];
+	uint64_t frameCount = 0;
+};
+
+//  The profiler every zone records into
+//
+Profiler &profiler();
+
+//  Times the scope it lives in
+//
+class ProfileZone {
+public:
+	ProfileZone(const char *name) {
+		this->name = name;
+		start = profiler().now();
+	}
+	~ProfileZone() {
+		profiler().record(name, start, profiler().now());
+	}
+
+private:
+	const char *name;
+	double start;
+};
+
+#define PROFILE_CONCAT2(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT2(a, b)
+#define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name)
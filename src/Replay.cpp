@@ -0,0 +1,217 @@
+#include "Replay.h"
+#include "ImageRegistry.h"
+
+static const char replayMagic[4] = { 'D', 'P', 'R', 'P' };
+static const uint32_t replayVersion = 2;
+
+template <class T>
+static void writeRaw(ofstream &file, const T &value) {
+	file.write((const char *)&value, sizeof(T));
+}
+
+template <class T>
+static bool readRaw(ifstream &file, T &value) {
+	return bool(file.read((char *)&value, sizeof(T)));
+}
+
+static void writeString(ofstream &file, const string &s) {
+	writeRaw(file, uint32_t(s.size()));
+	file.write(s.data(), s.size());
+}
+
+static bool readString(ifstream &file, string &s) {
+	uint32_t n;
+	if (!readRaw(file, n) || n > 4096) return false;
+	s.resize(n);
+	return bool(file.read(&s[0], n));
+}
+
+static uint8_t packControls(const WorldControls &c) {
+	return (c.up ? 1 : 0) | (c.down ? 2 : 0) | (c.left ? 4 : 0) | (c.right ? 8 : 0);
+}
+
+static WorldControls unpackControls(uint8_t bits) {
+	WorldControls c;
+	c.up = bits & 1;
+	c.down = bits & 2;
+	c.left = bits & 4;
+	c.right = bits & 8;
+	return c;
+}
+
+//--------------------------------------------------------------
+//Starts a log for a world that was just set up (no steps run yet)
+bool ReplayRecorder::start(string path, World &world, string enemyImage, string beamImage) {
+	file.open(path, ios::binary);
+	if (!file) return false;
+	file.write(replayMagic, 4);
+	writeRaw(file, replayVersion);
+	writeRaw(file, uint32_t(world.seed));
+	writeRaw(file, world.width);
+	writeRaw(file, world.height);
+	writeRaw(file, world.stepDt);
+	writeString(file, enemyImage);
+	writeString(file, beamImage);
+	writeString(file, world.waves ? world.waves->path : "");
+	writeRaw(file, world.waves ? world.waves->difficulty : 1.0f);
+	bFirst = true;
+	world.recorder = this;
+	return true;
+}
+
+void ReplayRecorder::writeEvent(uint8_t type, uint32_t step) {
+	writeRaw(file, type);
+	writeRaw(file, step);
+}
+
+//Writes the inputs that changed since the last step
+void ReplayRecorder::step(World &world) {
+	if (bFirst || packControls(world.controls) != packControls(lastControls)) {
+		writeEvent(replayControls, world.stepCount);
+		writeRaw(file, packControls(world.controls));
+		lastControls = world.controls;
+	}
+	if (bFirst || memcmp(&world.settings, &lastSettings, sizeof(WorldSettings)) != 0) {
+		writeEvent(replaySettings, world.stepCount);
+		writeRaw(file, world.settings);
+		lastSettings = world.settings;
+	}
+	bFirst = false;
+}
+
+void ReplayRecorder::fire(World &world) {
+	writeEvent(replayFire, world.stepCount);
+}
+
+void ReplayRecorder::stop(World &world) {
+	if (!file.is_open()) return;
+	writeEvent(replayEnd, world.stepCount);
+	file.close();
+	world.recorder = NULL;
+}
+
+bool ReplayRecorder::isRecording() {
+	return file.is_open();
+}
+
+//--------------------------------------------------------------
+bool ReplayLog::load(string path) {
+	ifstream file(path, ios::binary);
+	char magic[4];
+	uint32_t version;
+	if (!file.read(magic, 4) || memcmp(magic, replayMagic, 4) != 0) return false;
+	if (!readRaw(file, version) || version != replayVersion) return false;
+	if (!readRaw(file, seed) || !readRaw(file, width) || !readRaw(file, height) || !readRaw(file, stepDt)) return false;
+	if (!readString(file, enemyImage) || !readString(file, beamImage)) return false;
+	if (!readString(file, waves) || !readRaw(file, difficulty)) return false;
+
+	events.clear();
+	steps = 0;
+	while (true) {
+		ReplayEvent e;
+		if (!readRaw(file, e.type) || !readRaw(file, e.step)) return false;   // no end event
+		if (e.type == replayEnd) {
+			steps = e.step;
+			return true;
+		}
+		if (e.type == replayControls) {
+			uint8_t bits;
+			if (!readRaw(file, bits)) return false;
+			e.controls = unpackControls(bits);
+		}
+		else if (e.type == replaySettings) {
+			if (!readRaw(file, e.settings)) return false;
+		}
+		else if (e.type != replayFire) return false;
+		events.push_back(e);
+	}
+}
+
+//--------------------------------------------------------------
+int runReplay(int argc, char *argv[]) {
+	if (argc < 3) {
+		cerr << "usage: --replay file" << endl;
+		return 1;
+	}
+	ReplayLog log;
+	if (!log.load(argv[2])) {
+		cerr << "can't read replay " << argv[2] << endl;
+		return 1;
+	}
+
+	// images without textures, there is no GL context; their masks are
+	// what the collisions need
+	ImageRegistry images;
+	images.bUseTexture = false;
+	World world;
+	StepClock clock;
+	WaveSchedule waves;
+	if (log.waves != "") {
+		if (!waves.load(log.waves)) {
+			cerr << "can't read waves " << log.waves << endl;
+			return 1;
+		}
+		waves.build(log.difficulty);
+		world.waves = &waves;
+	}
+	world.setup(&clock, log.seed, log.width, log.height);
+	if (log.enemyImage != "") {
+		ofImage *img = images.load(log.enemyImage);
+		if (img) world.enemyEmitter->setChildImage(img, images.getMask(img));
+	}
+	if (log.beamImage != "") {
+		ofImage *img = images.load(log.beamImage);
+		if (img) world.beamEmitter->setChildImage(img, images.getMask(img));
+	}
+
+	vector<double> times(log.steps);
+	int next = 0;
+	for (uint32_t s = 0; s < log.steps; s++) {
+		for (; next < log.events.size() && log.events[next].step == s; next++) {
+			ReplayEvent &e = log.events[next];
+			if (e.type == replayControls) world.controls = e.controls;
+			else if (e.type == replaySettings) world.setSettings(e.settings);
+			else if (e.type == replayFire) world.fire();
+		}
+		double start = profiler().now();
+		world.step(log.stepDt);
+		times[s] = (profiler().now() - start) * 1000;
+	}
+
+	// a checksum of the end state, equal between runs of the same log
+	uint32_t hash = 2166136261u;
+	auto mix = [&](float f) {
+		uint32_t bits;
+		memcpy(&bits, &f, 4);
+		hash = (hash ^ bits) * 16777619u;
+	};
+	mix(world.player->pos.x);
+	mix(world.player->pos.y);
+	mix(world.player->rot);
+	mix(world.player->nEnergy);
+	Emitter *emitters[2] = { world.enemyEmitter, world.beamEmitter };
+	for (int i = 0; i < 2; i++) {
+		for (int j = 0; j < emitters[i]->sys->size(); j++) {
+			Sprite s = emitters[i]->sys->load(j);
+			mix(s.pos.x);
+			mix(s.pos.y);
+		}
+	}
+	for (int i = 0; i < world.explosions.size(); i++) {
+		int k = world.explosions.slot(i);
+		mix(world.explosions.x[k]);
+		mix(world.explosions.y[k]);
+	}
+
+	double total = 0;
+	for (int i = 0; i < times.size(); i++) total += times[i];
+	sort(times.begin(), times.end());
+	cout << "steps " << log.steps << "  enemies " << world.enemyEmitter->sys->size()
+		<< "  game over " << (world.bGameOver ? "yes" : "no") << endl;
+	if (times.size() > 0) {
+		cout << "ns/step avg " << total / times.size() << "  p50 " << times[times.size() / 2]
+			<< "  p99 " << times[(times.size() - 1) * 99 / 100] << endl;
+	}
+	cout << "checksum " << hex << hash << dec << endl;
+	return 0;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "ofMain.h"
+#include "World.h"
+
+//  Replay log of one game: the World's seed, arena, images and wave file,
+//  then the inputs as they change, each tagged with the fixed step it
+//  applies before. Since the World only depends on its seed, its step
+//  clock, its waves and these inputs, playing the log back re-runs the
+//  same game step for step.
+//
+//  The settings are stored as raw WorldSettings bytes, so a log only plays
+//  back on the build that recorded it. The enemies move with the widest
+//  SIMD kernel the CPU has (see SteerKernel), so it also has to be played
+//  back on a CPU with the same steerBestIsa().
+//
+enum replayEventType {
+	replayControls = 1,     // WorldControls changed (one bit per key)
+	replayFire = 2,         // World::fire
+	replaySettings = 3,     // WorldSettings changed
+	replayEnd = 4           // number of steps run
+};
+
+struct ReplayEvent {
+	uint8_t type;
+	uint32_t step;
+	WorldControls controls;
+	WorldSettings settings;
+};
+
+struct ReplayLog {
+	bool load(string path);
+
+	uint32_t seed;
+	float width, height;
+	float stepDt;
+	string enemyImage;      // "" if the enemies were triangles
+	string beamImage;
+	string waves;           // wave file, "" if the enemies came from the settings
+	float difficulty;       // the waves were built with
+	vector<ReplayEvent> events;
+	uint32_t steps;
+};
+
+//  Writes a replay log while a World runs. The World calls step() before
+//  each fixed step and fire() when the player fires (see World::recorder).
+//
+class ReplayRecorder {
+public:
+	bool start(string path, World &world, string enemyImage, string beamImage);
+	void step(World &world);
+	void fire(World &world);
+	void stop(World &world);
+	bool isRecording();
+
+private:
+	void writeEvent(uint8_t type, uint32_t step);
+
+	ofstream file;
+	bool bFirst;
+	WorldControls lastControls;
+	WorldSettings lastSettings;
+};
+
+//  "--replay file": play a log back headless, as fast as it runs, and
+//  print the time per step and a checksum of the final state
+//
+int runReplay(int argc, char *argv[]);
@@ -12,6 +12,7 @@ public:
 
 
 	}
+	virtual ~Shape() {}
 	virtual void draw() {
 
 		// draw a box by defaultd if not overridden
@@ -26,18 +27,116 @@ public:
 		return false;
 	}
 
+	// translate * rotate * scale. The matrix and its inverse are cached and
+	// only rebuilt when pos, rot or scale differ from the values they were
+	// built from (these are public and written all over, so the cache checks
+	// them instead of relying on setters).
+	//
 	glm::mat4 getTransform() {
-		glm::mat4 T = glm::translate(glm::mat4(1.0), glm::vec3(pos));
-		glm::mat4 R = glm::rotate(glm::mat4(1.0), glm::radians(rot), glm::vec3(0, 0, 1));
-		glm::mat4 S = glm::scale(glm::mat4(1.0), scale);      // added this scale if you want to change size of object
+		if (transformDirty()) updateTransform();
+		return transform;
+	}
+
+	glm::mat4 getInverseTransform() {
+		if (transformDirty()) updateTransform();
+		return inverseTransform;
+	}
+
+	// cos and sin of rot, recomputed only when rot changes. The 2D helpers
+	// below and Sprite::heading are built on it, so they need no matrix.
+	//
+	glm::vec2 cosSin() {
+		if (rot != cosSinRot) {
+			float r = glm::radians(rot);
+			rotCosSin = glm::vec2(cos(r), sin(r));
+			cosSinRot = rot;
+		}
+		return rotCosSin;
+	}
+
+	// object space point to world space, same as getTransform() * p
+	//
+	glm::vec3 toWorld(glm::vec3 p) {
+		glm::vec2 cs = cosSin();
+		float x = p.x * scale.x;
+		float y = p.y * scale.y;
+		return glm::vec3(cs.x * x - cs.y * y + pos.x, cs.y * x + cs.x * y + pos.y, p.z * scale.z + pos.z);
+	}
+
+	// world space point to object space, same as getInverseTransform() * p
+	//
+	glm::vec3 toObject(glm::vec3 p) {
+		glm::vec2 cs = cosSin();
+		float x = p.x - pos.x;
+		float y = p.y - pos.y;
+		return glm::vec3((cs.x * x + cs.y * y) / scale.x, (-cs.y * x + cs.x * y) / scale.y, (p.z - pos.z) / scale.z);
+	}
+
+	// transform blended between the previous simulation step (alpha = 0)
+	// and the current one (alpha = 1), for drawing between fixed steps
+	//
+	glm::mat4 getTransform(float alpha) {
+		glm::vec3 p = glm::mix(prevPos, pos, alpha);
+		float r = glm::mix(prevRot, rot, alpha);
+		glm::mat4 T = glm::translate(glm::mat4(1.0), p);
+		glm::mat4 R = glm::rotate(glm::mat4(1.0), glm::radians(r), glm::vec3(0, 0, 1));
+		glm::mat4 S = glm::scale(glm::mat4(1.0), scale);
 		return T*R*S;
 	}
+
+	// remember the current state as the previous step
+	//
+	void savePrevious() {
+		prevPos = pos;
+		prevRot = rot;
+	}
+
 	glm::vec3 pos;
 	float rot = 0.0;    // degrees 
+	glm::vec3 prevPos;
+	float prevRot = 0.0;
 	glm::vec3 scale = glm::vec3(1, 1, 1);
 	float defaultSize = 20.0;
 
 	bool bExplosion = false;
 	bool bBeam = false;
 	bool bEngine = false;
+
+private:
+	bool transformDirty() {
+		return pos != cachedPos || rot != cachedRot || scale != cachedScale;
+	}
+
+	// build T*R*S directly, and its inverse as S^-1 * R^T * T^-1 (rotation
+	// is only about z), so no general 4x4 inverse is needed
+	//
+	void updateTransform() {
+		glm::vec2 cs = cosSin();
+		float c = cs.x;
+		float s = cs.y;
+		transform = glm::mat4(1.0);
+		transform[0] = glm::vec4(c * scale.x, s * scale.x, 0, 0);
+		transform[1] = glm::vec4(-s * scale.y, c * scale.y, 0, 0);
+		transform[2] = glm::vec4(0, 0, scale.z, 0);
+		transform[3] = glm::vec4(pos.x, pos.y, pos.z, 1);
+
+		inverseTransform = glm::mat4(1.0);
+		inverseTransform[0] = glm::vec4(c / scale.x, -s / scale.y, 0, 0);
+		inverseTransform[1] = glm::vec4(s / scale.x, c / scale.y, 0, 0);
+		inverseTransform[2] = glm::vec4(0, 0, 1 / scale.z, 0);
+		inverseTransform[3] = glm::vec4(-(c * pos.x + s * pos.y) / scale.x,
+			-(-s * pos.x + c * pos.y) / scale.y, -pos.z / scale.z, 1);
+
+		cachedPos = pos;
+		cachedRot = rot;
+		cachedScale = scale;
+	}
+
+	glm::mat4 transform;
+	glm::mat4 inverseTransform;
+	glm::vec3 cachedPos;
+	float cachedRot = NAN;     // never equal, so the first call builds the cache
+	glm::vec3 cachedScale;
+	glm::vec2 rotCosSin;
+	float cosSinRot = NAN;
 };
\ No newline at end of file
@@ -0,0 +1,131 @@
+#include "SpatialGrid.h"
+
+SpatialGrid::SpatialGrid() {
+	cellSize = 100;
+	bSwept = false;
+	maxSweep = 1000;
+	nCandidates = 0;
+	nRejected = 0;
+	queryId = 0;
+	nSprites = 0;
+}
+
+void SpatialGrid::setCellSize(float size) {
+	cellSize = size;
+}
+
+void SpatialGrid::resetCounters() {
+	nCandidates = 0;
+	nRejected = 0;
+}
+
+int64_t SpatialGrid::cellKey(int x, int y) {
+	return (int64_t(x) << 32) | uint32_t(y);
+}
+
+//  A cell coordinate an int can hold; false for NaN and inf too
+//
+static bool validCell(float c) {
+	return c > -1e9 && c < 1e9;
+}
+
+static bool finite(glm::vec3 p) {
+	return std::isfinite(p.x) && std::isfinite(p.y);
+}
+
+//  Find the range of cells covered by the sprite. The sprite may be rotated,
+//  so use the circle around its width/height box (scaled) as the bounds.
+//  Swept, the bounds are the box around that circle at prevPos and at pos.
+//  A sprite at a NaN or infinite position gets an empty range (x1 < x0),
+//  so it is in no cell and finds nothing.
+//
+void SpatialGrid::cellRange(Sprite &s, int &x0, int &y0, int &x1, int &y1) {
+	float sc = MAX(fabs(s.scale.x), fabs(s.scale.y));
+	float r = 0.5 * sqrt(s.width * s.width + s.height * s.height) * sc;
+	glm::vec3 lo = s.pos;
+	glm::vec3 hi = s.pos;
+	if (bSwept && finite(s.prevPos) && glm::distance(s.pos, s.prevPos) < maxSweep) {
+		lo = glm::min(lo, s.prevPos);
+		hi = glm::max(hi, s.prevPos);
+	}
+	float cx0 = floor((lo.x - r) / cellSize);
+	float cy0 = floor((lo.y - r) / cellSize);
+	float cx1 = floor((hi.x + r) / cellSize);
+	float cy1 = floor((hi.y + r) / cellSize);
+	if (!finite(s.pos) || !validCell(cx0) || !validCell(cy0) || !validCell(cx1) || !validCell(cy1)) {
+		x0 = y0 = 0;
+		x1 = y1 = -1;
+		return;
+	}
+	x0 = cx0;
+	y0 = cy0;
+	x1 = cx1;
+	y1 = cy1;
+}
+
+//  Rebuild the grid from a list of sprites. Each sprite is entered in every
+//  cell it overlaps, then the entries are sorted so that a cell lookup is a
+//  binary search.  The vectors keep their capacity from frame to frame.
+//
+void SpatialGrid::build(vector<Sprite> &sprites) {
+	entries.clear();
+	nSprites = sprites.size();
+	stamps.assign(nSprites, -1);
+	queryId = 0;
+
+	for (int i = 0; i < sprites.size(); i++) {
+		int x0, y0, x1, y1;
+		cellRange(sprites[i], x0, y0, x1, y1);
+		for (int y = y0; y <= y1; y++) {
+			for (int x = x0; x <= x1; x++) {
+				Entry e;
+				e.key = cellKey(x, y);
+				e.index = i;
+				entries.push_back(e);
+			}
+		}
+	}
+	sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) {
+		return a.key < b.key;
+	});
+}
+
+//  Add a candidate pair for every sprite in the grid that shares a cell
+//  with sprite s. Each pair is only reported once, even if the sprites
+//  share several cells.
+//
+void SpatialGrid::query(Sprite &s, int index, FrameVector<CollisionPair> &pairs) {
+	queryId++;
+	int found = 0;
+	int x0, y0, x1, y1;
+	cellRange(s, x0, y0, x1, y1);
+	for (int y = y0; y <= y1; y++) {
+		for (int x = x0; x <= x1; x++) {
+			Entry e;
+			e.key = cellKey(x, y);
+			vector<Entry>::iterator it = lower_bound(entries.begin(), entries.end(), e,
+				[](const Entry &a, const Entry &b) { return a.key < b.key; });
+			while (it != entries.end() && it->key == e.key) {
+				if (stamps[it->index] != queryId) {
+					stamps[it->index] = queryId;
+					CollisionPair p;
+					p.a = index;
+					p.b = it->index;
+					pairs.push_back(p);
+					found++;
+				}
+				it++;
+			}
+		}
+	}
+	nCandidates += found;
+	nRejected += nSprites - found;
+}
+
+//  Query every sprite in a list against the grid.
+//
+void SpatialGrid::query(vector<Sprite> &sprites, FrameVector<CollisionPair> &pairs) {
+	for (int i = 0; i < sprites.size(); i++) {
+		query(sprites[i], i, pairs);
+	}
+}
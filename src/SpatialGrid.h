@@ -0,0 +1,54 @@
+#pragma once
+
+#include "ofMain.h"
+#include "Sprite.h"
+#include "FrameArena.h"
+
+// A pair of sprites that share at least one grid cell. "a" is the index
+// in the list that was queried, "b" is the index in the list the grid
+// was built from.
+//
+struct CollisionPair {
+	int a;
+	int b;
+};
+
+//  Uniform grid broad-phase for sprite collisions. The grid is rebuilt
+//  every frame from sprite positions and width/height, and then queried
+//  with another list of sprites.  Only the candidate pairs it returns need
+//  to go through the (expensive) insidePoint narrow-phase.
+//
+//  With bSwept set, a sprite covers the cells of its whole move in the last
+//  step (prevPos to pos), so a fast sprite is paired with everything it
+//  passed, not only what it ended up next to.  A move longer than maxSweep
+//  is taken as a jump (a reset or a runaway bounce) and not swept.
+//  Sprites at a NaN or infinite position are left out of the grid.
+//
+class SpatialGrid {
+public:
+	SpatialGrid();
+	void setCellSize(float);
+	void build(vector<Sprite> &sprites);
+	void query(vector<Sprite> &sprites, FrameVector<CollisionPair> &pairs);
+	void query(Sprite &s, int index, FrameVector<CollisionPair> &pairs);
+	void resetCounters();
+
+	float cellSize;
+	bool bSwept;        // cover prevPos too (see above)
+	float maxSweep;     // px
+	int nCandidates;    // pairs handed to the narrow-phase
+	int nRejected;      // pairs the broad-phase ruled out
+
+private:
+	struct Entry {
+		int64_t key;
+		int index;
+	};
+	int64_t cellKey(int x, int y);
+	void cellRange(Sprite &s, int &x0, int &y0, int &x1, int &y1);
+
+	vector<Entry> entries;   // sorted by cell key after build()
+	vector<int> stamps;      // last query that reported each sprite
+	int queryId;
+	int nSprites;
+};
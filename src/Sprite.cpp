@@ -15,13 +15,14 @@ bool Sprite::insidePoint(const glm::vec3 p) {
 	// in object space.  If point is inside bounds, then make sure the point is in
 	// opaque part of image.
 	//
-	glm::vec3 s = glm::inverse(getTransform()) * glm::vec4(p, 1);
-	int w = spriteImage.getWidth();
-	int h = spriteImage.getHeight();
+	glm::vec3 s = toObject(p);
+	int w = spriteImage->getWidth();
+	int h = spriteImage->getHeight();
 	if (s.x > -w / 2 && s.x < w / 2 && s.y > -h / 2 && s.y < h / 2) {
 		int x = s.x + w / 2;
 		int y = s.y + h / 2;
-		ofColor color = spriteImage.getColor(x, y);
+		if (mask) return mask->test(x, y);
+		ofColor color = spriteImage->getColor(x, y);
 		return (color.a != 0);   // check if color is opaque (not the transparent background)
 	}
 	else return false;
@@ -33,7 +34,7 @@ bool Sprite::insideTriangle(const glm::vec3 p) {
 	// oordinate system  (object space);  this will take into account any
 	// rotation, translation or scale on the object.
 	//
-	glm::vec4 p2 = glm::inverse(getTransform()) * glm::vec4(p, 1);
+	glm::vec3 p2 = toObject(p);
 
 	glm::vec3 v1 = glm::normalize(verts[0] - p2);
 	glm::vec3 v2 = glm::normalize(verts[1] - p2);
@@ -45,12 +46,9 @@ bool Sprite::insideTriangle(const glm::vec3 p) {
 	else return false;
 }
 
-void Sprite::integrate() {
-
-
-	// interval for this step
-	//
-	float dt = 1.0 / ofGetFrameRate();
+//  Advance the physics by dt seconds
+//
+void Sprite::integrate(float dt) {
 
 	// update position based on velocity
 	//
@@ -88,10 +86,10 @@ void Sprite::addAngularForces(float f) {
 	angularForce = f;
 }
 
-//Returns heading of the sprite
+//Returns heading of the sprite: (0, -1) rotated by rot
 glm::vec3 Sprite::heading() {
-	glm::mat4 rot2 = glm::rotate(glm::mat4(1.0), glm::radians(rot), glm::vec3(0, 0, 1));
-	return glm::normalize(rot2 * glm::vec4(0, -1, 0, 1));
+	glm::vec2 cs = cosSin();
+	return glm::vec3(cs.y, -cs.x, 0);
 }
 
 void Sprite::setVelocity(glm::vec3 v) {
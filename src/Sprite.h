@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Shape.h"
+#include "AlphaMask.h"
 
 
 
@@ -12,24 +13,68 @@
 class Sprite : public Shape {
 public:
 	Sprite() {
+		reset();
+	}
+
+	// put the sprite back in its just-constructed state. verts is refilled
+	// in place, so a pooled sprite can be reused without allocating.
+	//
+	void reset() {
+		pos = glm::vec3(0, 0, 0);
+		rot = 0.0;
+		prevPos = pos;
+		prevRot = rot;
+		scale = glm::vec3(1, 1, 1);
+		bExplosion = false;
+		bBeam = false;
+		bEngine = false;
+		bHighlight = false;
+		bSelected = false;
+		bShowImage = false;
+		acceleration = glm::vec3(0, 0, 0);
+		forces = glm::vec3(0, 0, 0);
+		velocity = glm::vec3(0, 0, 0);
+		angularForce = 0;
+		angularVelocity = 0;
+		angularAcceleration = 0;
+		mass = 1.0;
+		damping = .96;
+		rotationSpeed = 0.0;
+		moveSpeed = 50;
+		birthtime = 0;
+		lifespan = -1;
+		name = "UnammedSprite";
+		width = 0;
+		height = 0;
+		spriteImage = NULL;
+		mask = NULL;
+		nEnergy = 5;
+
 		// default geometry (triangle) if no image attached.
 		//
+		verts.resize(3);
 		//bottom left
-		verts.push_back(glm::vec3(-20, 30, 0));
+		verts[0] = glm::vec3(-20, 30, 0);
 		//bottom right
-		verts.push_back(glm::vec3(20, 30, 0));
+		verts[1] = glm::vec3(20, 30, 0);
 		//top
-		verts.push_back(glm::vec3(0, -30, 0));
+		verts[2] = glm::vec3(0, -30, 0);
 	}
 	
 	// some functions for highlighting when selected
 	//
 	void draw() {
+		draw(1.0);
+	}
+
+	// draw blended between the previous and current step (see Shape)
+	//
+	void draw(float alpha) {
 		if (bShowImage) {
 			ofPushMatrix();
 			ofSetColor(ofColor::white);
-			ofMultMatrix(getTransform());
-			spriteImage.draw(-spriteImage.getWidth() / 2, -spriteImage.getHeight() / 2.0);
+			ofMultMatrix(getTransform(alpha));
+			spriteImage->draw(-spriteImage->getWidth() / 2, -spriteImage->getHeight() / 2.0);
 			ofPopMatrix();
 		}
 		else
@@ -37,21 +82,26 @@ public:
 			if (bHighlight) ofSetColor(ofColor::white);
 			else ofSetColor(ofColor::green);
 			ofPushMatrix();
-			ofMultMatrix(getTransform());
+			ofMultMatrix(getTransform(alpha));
 			ofDrawTriangle(verts[0], verts[1], verts[2]);
 			ofPopMatrix();
 		}
 	}
 
-	float age() {
-		return (ofGetElapsedTimeMillis() - birthtime);
+	// age in ms at time "now" (ms, same clock as birthtime)
+	//
+	float age(float now) {
+		return (now - birthtime);
 	}
 
-	void setImage(ofImage img) {
+	// the image and its mask are shared, not copied (see ImageRegistry)
+	//
+	void setImage(ofImage *img, AlphaMask *mask = NULL) {
 		spriteImage = img;
+		this->mask = mask;
 		bShowImage = true;
-		width = img.getWidth();
-		height = img.getHeight();
+		width = img->getWidth();
+		height = img->getHeight();
 	}
 
 	virtual bool insidePoint(const glm::vec3 p);
@@ -72,7 +122,7 @@ public:
 	bool isSelected() { return bSelected; }
 	bool isHighlight() { return bHighlight; }
 
-	void integrate();
+	void integrate(float dt);
 	void addForces(glm::vec3 f);
 	void addAngularForces(float f);
 	
@@ -97,9 +147,10 @@ public:
 	float birthtime = 0; // elapsed time in ms
 	float lifespan = -1;  //  time in ms
 	string name =  "UnammedSprite";
-	float width;
-	float height;
-	ofImage spriteImage;
+	float width = 0;
+	float height = 0;
+	ofImage *spriteImage = NULL;
+	AlphaMask *mask = NULL;
 	int nEnergy = 5;
 
 	// default verts for polyline shape if no image on sprite
@@ -0,0 +1,88 @@
+#include "SpriteArrays.h"
+
+void SpriteArrays::reserve(int n) {
+	pos.reserve(n);
+	velocity.reserve(n);
+	forces.reserve(n);
+	rot.reserve(n);
+	angularVelocity.reserve(n);
+	birthtime.reserve(n);
+	lifespan.reserve(n);
+}
+
+void SpriteArrays::resize(int n) {
+	pos.resize(n);
+	velocity.resize(n);
+	forces.resize(n);
+	rot.resize(n);
+	angularVelocity.resize(n);
+	birthtime.resize(n);
+	lifespan.resize(n);
+}
+
+void SpriteArrays::clear() {
+	pos.clear();
+	velocity.clear();
+	forces.clear();
+	rot.clear();
+	angularVelocity.clear();
+	birthtime.clear();
+	lifespan.clear();
+}
+
+//  Append the physics state of a sprite
+//
+void SpriteArrays::push(const Sprite &s) {
+	pos.push_back(s.pos);
+	velocity.push_back(s.velocity);
+	forces.push_back(s.forces);
+	rot.push_back(s.rot);
+	angularVelocity.push_back(s.angularVelocity);
+	birthtime.push_back(s.birthtime);
+	lifespan.push_back(s.lifespan);
+}
+
+//  Remove sprite i by moving the last sprite into its slot. This does not
+//  keep the order of the sprites, but nothing has to be shifted.
+//
+void SpriteArrays::swapRemove(int i) {
+	int last = size() - 1;
+	pos[i] = pos[last];
+	velocity[i] = velocity[last];
+	forces[i] = forces[last];
+	rot[i] = rot[last];
+	angularVelocity[i] = angularVelocity[last];
+	birthtime[i] = birthtime[last];
+	lifespan[i] = lifespan[last];
+	pos.pop_back();
+	velocity.pop_back();
+	forces.pop_back();
+	rot.pop_back();
+	angularVelocity.pop_back();
+	birthtime.pop_back();
+	lifespan.pop_back();
+}
+
+//  Copy the state of sprite i into s
+//
+void SpriteArrays::read(int i, Sprite &s) {
+	s.pos = pos[i];
+	s.velocity = velocity[i];
+	s.forces = forces[i];
+	s.rot = rot[i];
+	s.angularVelocity = angularVelocity[i];
+	s.birthtime = birthtime[i];
+	s.lifespan = lifespan[i];
+}
+
+//  Copy the state of s back into sprite i
+//
+void SpriteArrays::write(int i, const Sprite &s) {
+	pos[i] = s.pos;
+	velocity[i] = s.velocity;
+	forces[i] = s.forces;
+	rot[i] = s.rot;
+	angularVelocity[i] = s.angularVelocity;
+	birthtime[i] = s.birthtime;
+	lifespan[i] = s.lifespan;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "ofMain.h"
+#include "Sprite.h"
+
+//  Per-sprite physics state kept in parallel contiguous arrays (structure
+//  of arrays). Loops that only touch pos and velocity don't have to stride
+//  over each sprite's image, name and verts.  Everything that is the same
+//  for every sprite in a list lives on the list's archetype sprite instead.
+//
+class SpriteArrays {
+public:
+	int size() { return pos.size(); }
+	void reserve(int n);
+	void resize(int n);
+	void clear();
+	void push(const Sprite &s);
+	void swapRemove(int i);
+	void read(int i, Sprite &s);
+	void write(int i, const Sprite &s);
+
+	vector<glm::vec3> pos;
+	vector<glm::vec3> velocity;
+	vector<glm::vec3> forces;
+	vector<float> rot;
+	vector<float> angularVelocity;
+	vector<float> birthtime;
+	vector<float> lifespan;
+};
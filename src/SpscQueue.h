@@ -0,0 +1,42 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+//  Fixed size ring buffer for one producer thread and one consumer thread.
+//  push and pop never lock or allocate: each side owns one index and
+//  publishes it to the other with release/acquire.  Size must be a power
+//  of two; one slot is kept empty to tell full from empty.
+//
+template <class T, size_t Size>
+class SpscQueue {
+public:
+	SpscQueue() : head(0), tail(0) {}
+
+	// producer: false if the queue is full (the item is dropped)
+	//
+	bool push(const T &item) {
+		size_t t = tail.load(std::memory_order_relaxed);
+		size_t next = (t + 1) & (Size - 1);
+		if (next == head.load(std::memory_order_acquire)) return false;
+		items[t] = item;
+		tail.store(next, std::memory_order_release);
+		return true;
+	}
+
+	// consumer: false if the queue is empty
+	//
+	bool pop(T &item) {
+		size_t h = head.load(std::memory_order_relaxed);
+		if (h == tail.load(std::memory_order_acquire)) return false;
+		item = items[h];
+		head.store((h + 1) & (Size - 1), std::memory_order_release);
+		return true;
+	}
+
+private:
+	static_assert((Size & (Size - 1)) == 0, "SpscQueue size must be a power of two");
+	T items[Size];
+	std::atomic<size_t> head;   // next item to pop, written by the consumer
+	std::atomic<size_t> tail;   // next free slot, written by the producer
+};
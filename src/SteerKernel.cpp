@@ -0,0 +1,85 @@
+#include "SteerKernel.h"
+
+#if STEER_X86 && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+//  Widest instruction set this CPU runs. SSE2 is part of every x86-64 CPU,
+//  the AVX2 kernel also uses FMA and needs the CPU and the OS (saved ymm
+//  registers) to support both.
+//
+steerIsa steerBestIsa() {
+#if STEER_X86
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] >= 7) {
+		__cpuid(info, 1);
+		bool fma = (info[2] & (1 << 12)) != 0;
+		bool osxsave = (info[2] & (1 << 27)) != 0;
+		bool ymm = osxsave && (_xgetbv(0) & 6) == 6;
+		__cpuidex(info, 7, 0);
+		if (ymm && fma && (info[1] & (1 << 5))) return steerAVX2;
+	}
+	return steerSSE;
+#else
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return steerAVX2;
+	if (__builtin_cpu_supports("sse2")) return steerSSE;
+#endif
+#endif
+	return steerScalar;
+}
+
+const char *steerIsaName(steerIsa isa) {
+	switch (isa) {
+	case steerSSE: return "sse2";
+	case steerAVX2: return "avx2";
+	default: return "scalar";
+	}
+}
+
+//  One sprite at a time, the reference version of the step
+//
+static void steerChaseScalar(SpriteArrays &a, int begin, int end, const SteerParams &p) {
+	for (int i = begin; i < end; i++) {
+		glm::vec3 v = glm::normalize(p.target - a.pos[i]);
+		float r = glm::radians(a.rot[i]);
+		glm::vec3 h = glm::vec3(sin(r), -cos(r), 0);
+		float dotp = glm::dot(h, v);
+		float crossz = h.x * v.y - h.y * v.x;
+		if (dotp < (1.0 - p.eps)) {
+			if (crossz > 0.0) a.rot[i] += p.turn;
+			else a.rot[i] -= p.turn;
+		}
+		a.forces[i] = p.force * v;
+
+		// integrate
+		//
+		a.pos[i] += a.velocity[i] * p.dt;
+		glm::vec3 accel = p.acceleration + a.forces[i] * p.invMass;
+		a.velocity[i] += accel * p.dt;
+		a.velocity[i] *= p.damping;
+		a.rot[i] += a.angularVelocity[i] * p.dt;
+		a.angularVelocity[i] += p.angularAcceleration * p.dt;
+		a.angularVelocity[i] *= p.damping;
+		a.forces[i] = glm::vec3(0, 0, 0);
+
+		// move along velocity
+		//
+		a.pos[i] += a.velocity[i] * p.dt;
+	}
+}
+
+//  Run the step on sprites [begin, end) with the given instruction set.
+//  Sprites are batched from begin, so the same range is always split the
+//  same way and gives the same results.
+//
+void steerChase(SpriteArrays &a, int begin, int end, const SteerParams &p, steerIsa isa) {
+	int done = begin;
+#if STEER_X86
+	if (isa == steerAVX2) done = steerChaseAVX2(a, begin, end, p);
+	else if (isa == steerSSE) done = steerChaseSSE(a, begin, end, p);
+#endif
+	steerChaseScalar(a, done, end, p);
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "ofMain.h"
+#include "SpriteArrays.h"
+
+//  The enemy chase step on the sprite arrays (see AgentEmitter::moveSprites):
+//  turn towards the target, push towards it, integrate and move.
+//
+//  The batch versions do 4 (SSE2) or 8 (AVX2) sprites per iteration and
+//  leave the last few to the scalar code.  The arena is flat, so they work
+//  in x and y only; z is left as it is.  Their sin/cos is a polynomial, so
+//  they can differ from the scalar code in the last bits.
+//
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define STEER_X86 1
+#else
+#define STEER_X86 0
+#endif
+
+enum steerIsa {
+	steerScalar,
+	steerSSE,
+	steerAVX2
+};
+
+struct SteerParams {
+	glm::vec3 target;
+	float turn;             // deg per step when not facing the target
+	float eps;              // facing if dot(heading, target dir) >= 1 - eps
+	float force;
+	glm::vec3 acceleration;
+	float invMass;
+	float angularAcceleration;
+	float damping;
+	float dt;
+};
+
+steerIsa steerBestIsa();
+const char *steerIsaName(steerIsa isa);
+void steerChase(SpriteArrays &a, int begin, int end, const SteerParams &p, steerIsa isa);
+
+// batch kernels, each returns the first sprite it didn't do
+int steerChaseSSE(SpriteArrays &a, int begin, int end, const SteerParams &p);
+int steerChaseAVX2(SpriteArrays &a, int begin, int end, const SteerParams &p);
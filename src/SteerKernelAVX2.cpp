@@ -0,0 +1,49 @@
+#include "SteerKernel.h"
+
+#if STEER_X86
+
+// everything below may use AVX2 and FMA; it only runs when steerBestIsa()
+// says so. MSVC builds this file with /arch:AVX2 (see the .vcxproj files)
+#if defined(__GNUC__)
+#pragma GCC target("avx2,fma")
+#endif
+
+#include <immintrin.h>
+#include "SteerKernelBatch.h"
+
+namespace {
+
+struct AVX2Ops {
+	typedef __m256 V;
+	static const int N = 8;
+	static V set1(float x) { return _mm256_set1_ps(x); }
+	static V load(const float *p) { return _mm256_loadu_ps(p); }
+	static void store(float *p, V x) { _mm256_storeu_ps(p, x); }
+	static V gather3(const float *p) {
+		return _mm256_i32gather_ps(p, _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21), 4);
+	}
+	static V add(V a, V b) { return _mm256_add_ps(a, b); }
+	static V sub(V a, V b) { return _mm256_sub_ps(a, b); }
+	static V mul(V a, V b) { return _mm256_mul_ps(a, b); }
+	static V div(V a, V b) { return _mm256_div_ps(a, b); }
+	static V sqrt(V a) { return _mm256_sqrt_ps(a); }
+	static V lt(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+	static V gt(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+	static V select(V m, V a, V b) { return _mm256_blendv_ps(b, a, m); }
+	static V bitAnd(V a, V b) { return _mm256_and_ps(a, b); }
+	static V bitXor(V a, V b) { return _mm256_xor_ps(a, b); }
+	static V roundQuadrant(V x, V &q1, V &q2) {
+		__m256i q = _mm256_cvtps_epi32(x);  // rounds to nearest
+		q1 = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(q, _mm256_set1_epi32(1)), _mm256_set1_epi32(1)));
+		q2 = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(q, _mm256_set1_epi32(2)), _mm256_set1_epi32(2)));
+		return _mm256_cvtepi32_ps(q);
+	}
+};
+
+}
+
+int steerChaseAVX2(SpriteArrays &a, int begin, int end, const SteerParams &p) {
+	return steerChaseBatch<AVX2Ops>(a, begin, end, p);
+}
+
+#endif
@@ -0,0 +1,129 @@
+#pragma once
+
+//  The chase step written once over a vector type, included by the SSE2
+//  and AVX2 kernels with their own Ops:
+//
+//    V                     float vector of N lanes
+//    set1, load, store     broadcast, contiguous load/store
+//    gather3               lanes from every 3rd float (x or y of a vec3 array)
+//    add sub mul div sqrt  lane wise math
+//    lt gt                 compare, all bits set where true
+//    select(m, a, b)       a where m is set, else b
+//    bitAnd bitXor         bit ops
+//    roundQuadrant(x, q1, q2)  x rounded to an integer, q1/q2 set where
+//                          bit 0/1 of that integer is set
+//
+//  Everything is in an anonymous namespace, so each kernel gets its own
+//  copy compiled for its own instruction set.
+//
+#include "SteerKernel.h"
+
+namespace {
+
+//  sin and cos of x (radians): reduce to y in [-pi/4, pi/4] around a
+//  multiple q of pi/2, evaluate the minimax polynomials for sin/cos on y
+//  (the Cephes sinf/cosf coefficients) and rotate the result by q
+//
+template <class Ops>
+inline void sinCos(typename Ops::V x, typename Ops::V &sinX, typename Ops::V &cosX) {
+	typedef typename Ops::V V;
+	V q1, q2;
+	V q = Ops::roundQuadrant(Ops::mul(x, Ops::set1(0.63661977236f)), q1, q2);
+
+	// x - q * pi/2, with pi/2 split in three so the subtraction stays exact
+	V y = Ops::sub(x, Ops::mul(q, Ops::set1(1.5703125f)));
+	y = Ops::sub(y, Ops::mul(q, Ops::set1(4.837512969970703125e-4f)));
+	y = Ops::sub(y, Ops::mul(q, Ops::set1(7.54978995489188216e-8f)));
+	V y2 = Ops::mul(y, y);
+
+	V s = Ops::set1(-1.9515295891e-4f);
+	s = Ops::add(Ops::mul(s, y2), Ops::set1(8.3321608736e-3f));
+	s = Ops::add(Ops::mul(s, y2), Ops::set1(-1.6666654611e-1f));
+	s = Ops::add(Ops::mul(Ops::mul(s, y2), y), y);
+
+	V c = Ops::set1(2.443315711809948e-5f);
+	c = Ops::add(Ops::mul(c, y2), Ops::set1(-1.388731625493765e-3f));
+	c = Ops::add(Ops::mul(c, y2), Ops::set1(4.166664568298827e-2f));
+	c = Ops::mul(Ops::mul(c, y2), y2);
+	c = Ops::add(Ops::sub(c, Ops::mul(y2, Ops::set1(.5f))), Ops::set1(1));
+
+	// quadrant 1: (c, -s)  2: (-s, -c)  3: (-c, s)
+	V sign = Ops::set1(-0.0f);
+	sinX = Ops::select(q1, c, s);
+	cosX = Ops::select(q1, s, c);
+	sinX = Ops::bitXor(sinX, Ops::bitAnd(q2, sign));
+	cosX = Ops::bitXor(cosX, Ops::bitAnd(Ops::bitXor(q1, q2), sign));
+}
+
+template <class Ops>
+int steerChaseBatch(SpriteArrays &a, int begin, int end, const SteerParams &p) {
+	typedef typename Ops::V V;
+	const int N = Ops::N;
+
+	V tx = Ops::set1(p.target.x), ty = Ops::set1(p.target.y);
+	V turn = Ops::set1(p.turn), noTurn = Ops::set1(0);
+	V facing = Ops::set1(1.0 - p.eps);
+	V force = Ops::set1(p.force), invMass = Ops::set1(p.invMass);
+	V ax = Ops::set1(p.acceleration.x), ay = Ops::set1(p.acceleration.y);
+	V angularStep = Ops::set1(p.angularAcceleration * p.dt);
+	V damping = Ops::set1(p.damping), dt = Ops::set1(p.dt);
+	V toRadians = Ops::set1(PI / 180);
+	V zero = Ops::set1(0);
+
+	float outX[N], outY[N], outVx[N], outVy[N];
+	int i = begin;
+	for (; i + N <= end; i += N) {
+		V px = Ops::gather3(&a.pos[i].x);
+		V py = Ops::gather3(&a.pos[i].y);
+		V vx = Ops::gather3(&a.velocity[i].x);
+		V vy = Ops::gather3(&a.velocity[i].y);
+		V rot = Ops::load(&a.rot[i]);
+		V angular = Ops::load(&a.angularVelocity[i]);
+
+		// direction to the target
+		V dx = Ops::sub(tx, px), dy = Ops::sub(ty, py);
+		V len = Ops::sqrt(Ops::add(Ops::mul(dx, dx), Ops::mul(dy, dy)));
+		dx = Ops::div(dx, len);
+		dy = Ops::div(dy, len);
+
+		// heading (sin r, -cos r) and which way to turn
+		V hx, hy;
+		sinCos<Ops>(Ops::mul(rot, toRadians), hx, hy);
+		hy = Ops::sub(zero, hy);
+		V dotp = Ops::add(Ops::mul(hx, dx), Ops::mul(hy, dy));
+		V crossz = Ops::sub(Ops::mul(hx, dy), Ops::mul(hy, dx));
+		V step = Ops::select(Ops::gt(crossz, zero), turn, Ops::sub(zero, turn));
+		rot = Ops::add(rot, Ops::select(Ops::lt(dotp, facing), step, noTurn));
+
+		// integrate, with the force towards the target
+		px = Ops::add(px, Ops::mul(vx, dt));
+		py = Ops::add(py, Ops::mul(vy, dt));
+		V accelX = Ops::add(ax, Ops::mul(Ops::mul(force, dx), invMass));
+		V accelY = Ops::add(ay, Ops::mul(Ops::mul(force, dy), invMass));
+		vx = Ops::mul(Ops::add(vx, Ops::mul(accelX, dt)), damping);
+		vy = Ops::mul(Ops::add(vy, Ops::mul(accelY, dt)), damping);
+		rot = Ops::add(rot, Ops::mul(angular, dt));
+		angular = Ops::mul(Ops::add(angular, angularStep), damping);
+
+		// move along velocity
+		px = Ops::add(px, Ops::mul(vx, dt));
+		py = Ops::add(py, Ops::mul(vy, dt));
+
+		Ops::store(&a.rot[i], rot);
+		Ops::store(&a.angularVelocity[i], angular);
+		Ops::store(outX, px);
+		Ops::store(outY, py);
+		Ops::store(outVx, vx);
+		Ops::store(outVy, vy);
+		for (int k = 0; k < N; k++) {
+			a.pos[i + k].x = outX[k];
+			a.pos[i + k].y = outY[k];
+			a.velocity[i + k].x = outVx[k];
+			a.velocity[i + k].y = outVy[k];
+			a.forces[i + k] = glm::vec3(0, 0, 0);
+		}
+	}
+	return i;
+}
+
+}
@@ -0,0 +1,40 @@
+#include "SteerKernel.h"
+
+#if STEER_X86
+#include <emmintrin.h>
+#include "SteerKernelBatch.h"
+
+namespace {
+
+struct SSEOps {
+	typedef __m128 V;
+	static const int N = 4;
+	static V set1(float x) { return _mm_set1_ps(x); }
+	static V load(const float *p) { return _mm_loadu_ps(p); }
+	static void store(float *p, V x) { _mm_storeu_ps(p, x); }
+	static V gather3(const float *p) { return _mm_setr_ps(p[0], p[3], p[6], p[9]); }
+	static V add(V a, V b) { return _mm_add_ps(a, b); }
+	static V sub(V a, V b) { return _mm_sub_ps(a, b); }
+	static V mul(V a, V b) { return _mm_mul_ps(a, b); }
+	static V div(V a, V b) { return _mm_div_ps(a, b); }
+	static V sqrt(V a) { return _mm_sqrt_ps(a); }
+	static V lt(V a, V b) { return _mm_cmplt_ps(a, b); }
+	static V gt(V a, V b) { return _mm_cmpgt_ps(a, b); }
+	static V select(V m, V a, V b) { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+	static V bitAnd(V a, V b) { return _mm_and_ps(a, b); }
+	static V bitXor(V a, V b) { return _mm_xor_ps(a, b); }
+	static V roundQuadrant(V x, V &q1, V &q2) {
+		__m128i q = _mm_cvtps_epi32(x);     // rounds to nearest
+		q1 = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(q, _mm_set1_epi32(1)), _mm_set1_epi32(1)));
+		q2 = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(q, _mm_set1_epi32(2)), _mm_set1_epi32(2)));
+		return _mm_cvtepi32_ps(q);
+	}
+};
+
+}
+
+int steerChaseSSE(SpriteArrays &a, int begin, int end, const SteerParams &p) {
+	return steerChaseBatch<SSEOps>(a, begin, end, p);
+}
+
+#endif
@@ -0,0 +1,87 @@
+#include "WaveSchedule.h"
+
+//Reads a wave file (see WaveSchedule) and builds it at difficulty 1.
+//Blank lines and lines starting with # are skipped. Returns false, and
+//leaves the schedule as it was, if the file can't be read or a line
+//doesn't parse
+//--------------------------------------------------------------
+bool WaveSchedule::load(string path) {
+	ifstream file(ofToDataPath(path));
+	if (!file) return false;
+	vector<WaveBurst> loaded;
+	string line;
+	int n = 0;
+	while (getline(file, line)) {
+		n++;
+		size_t start = line.find_first_not_of(" \t\r");
+		if (start == string::npos || line[start] == '#') continue;
+		istringstream in(line);
+		WaveBurst b;
+		if (!(in >> b.time >> b.count >> b.speed >> b.life >> b.x >> b.y >> b.w >> b.h)) {
+			cerr << path << ":" << n << ": expected time count speed life x y w h" << endl;
+			return false;
+		}
+		if (in >> b.every) {
+			if (!(in >> b.times)) {
+				cerr << path << ":" << n << ": repeat needs every and times" << endl;
+				return false;
+			}
+		}
+		loaded.push_back(b);
+	}
+	bursts.swap(loaded);
+	this->path = path;
+	build(difficulty);
+	return true;
+}
+
+void WaveSchedule::add(const WaveBurst &burst) {
+	bursts.push_back(burst);
+}
+
+//Expands the bursts into spawn events sorted by time, with the counts,
+//speeds and lives scaled by difficulty (like the sliders in ofApp::setupGui),
+//and works out how many enemies can be alive at once so the World can
+//size the enemy pool up front
+//--------------------------------------------------------------
+void WaveSchedule::build(float difficulty) {
+	this->difficulty = difficulty;
+	events.clear();
+	for (int i = 0; i < bursts.size(); i++) {
+		WaveBurst &b = bursts[i];
+		for (int k = 0; k < MAX(b.times, 1); k++) {
+			SpawnEvent e;
+			e.time = (b.time + k * b.every) * 1000;
+			e.count = MAX(1, int(b.count * difficulty + .5));
+			e.velocity = glm::vec3(b.speed, b.speed, 0) * difficulty;
+			e.lifespan = b.life * difficulty * 1000;
+			e.x = b.x;
+			e.y = b.y;
+			e.w = b.w;
+			e.h = b.h;
+			events.push_back(e);
+		}
+	}
+	// stable, so bursts at the same time spawn in file order
+	stable_sort(events.begin(), events.end(), [](const SpawnEvent &a, const SpawnEvent &b) {
+		return a.time < b.time;
+	});
+
+	// +count when a burst spawns, -count when it expires
+	vector<pair<float, int>> changes;
+	for (int i = 0; i < events.size(); i++) {
+		changes.push_back(make_pair(events[i].time, events[i].count));
+		changes.push_back(make_pair(events[i].time + events[i].lifespan, -events[i].count));
+	}
+	sort(changes.begin(), changes.end());
+	int alive = 0;
+	peakAlive = 0;
+	for (int i = 0; i < changes.size(); i++) {
+		alive += changes[i].second;
+		peakAlive = MAX(peakAlive, alive);
+	}
+}
+
+int WaveSchedule::size() {
+	return events.size();
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "ofMain.h"
+
+//  One line of a wave file: count enemies spawned at time, optionally
+//  repeated every "every" seconds, "times" times.  The region is where in
+//  the arena they appear, as fractions of its width and height.
+//
+struct WaveBurst {
+	float time = 0;         // seconds from the start of the game
+	int count = 1;
+	float speed = 150;      // initial velocity is (speed, speed)
+	float life = 5;         // seconds
+	float x = 0, y = 0, w = 1, h = 1;
+	float every = 0;        // seconds between repeats
+	int times = 1;
+};
+
+//  A burst as it is spawned: one per repeat of a WaveBurst, scaled by the
+//  difficulty, with the time and life in ms like the rest of the World.
+//
+struct SpawnEvent {
+	float time;
+	int count;
+	glm::vec3 velocity;
+	float lifespan;
+	float x, y, w, h;
+};
+
+//  Timeline of enemy spawns for a game, loaded from a text wave file:
+//
+//      # time  count  speed  life  x  y  w  h  [every times]
+//      0       5      150    5     0  0  1  1
+//      10      1000   200    30    0  0  1  .1   1  10
+//
+//  build() expands the repeats into "events", sorted by time, so the World
+//  only has to look at the next event each step (see World::spawnWaves).
+//  Everything that is due in a step is spawned together in one batch.
+//
+class WaveSchedule {
+public:
+	bool load(string path);
+	void add(const WaveBurst &burst);
+	void build(float difficulty = 1);
+	int size();
+
+	string path;            // file it was loaded from, "" if built in code
+	float difficulty = 1;   // multiplier on counts, speeds and lives
+	vector<WaveBurst> bursts;
+	vector<SpawnEvent> events;
+	int peakAlive = 0;      // most enemies alive at once if none are shot
+};
@@ -0,0 +1,551 @@
+#include "World.h"
+#include "Replay.h"
+#include <cassert>
+
+World::World() {
+	collisionPairs.setArena(&frameArena);
+	collisionHits.setArena(&frameArena);
+	collisionGrid.bSwept = true;
+	clock = NULL;
+	bGameOver = false;
+	width = 0;
+	height = 0;
+}
+
+World::~World() {
+	delete enemyEmitter;
+	delete beamEmitter;
+	delete player;
+}
+
+//Creates enemy and beam emitter along with player.
+//The clock and seed make a run repeatable, width/height is the arena.
+//Calling setup again resets the world for a new game: the emitters, their
+//sprite pools and the player are cleared in place instead of allocated
+//--------------------------------------------------------------
+void World::setup(Clock *clock, unsigned int seed, float width, float height) {
+	this->clock = clock;
+	this->width = width;
+	this->height = height;
+	this->seed = seed;
+	clock->reset();
+	rng.seed(seed);
+	stepCount = 0;
+	nExplosions = 0;
+	nextWave = 0;
+	bGameOver = false;
+	accumulator = 0;
+	controls = WorldControls();
+	dirty = dirtyAll;
+	bGridBuilt = false;
+
+	if (enemyEmitter == NULL) {
+		enemyEmitter = new AgentEmitter();  // C++ polymorphism
+		beamEmitter = new AgentEmitter();
+		player = new Sprite();
+		emitters.push_back(beamEmitter);
+		emitters.push_back(enemyEmitter);
+	}
+	else {
+		enemyEmitter->reset();
+		beamEmitter->reset();
+		player->reset();
+	}
+	explosions.clear();
+	assertSpriteStorage();
+
+	//Set up the enemy emitter and start it
+	enemyEmitter->world = this;
+	enemyEmitter->emitterType = enemySpawner;
+	enemyEmitter->pos = glm::vec3(width / 2.0, height / 2.0, 0);
+	enemyEmitter->drawable = true;
+	enemyEmitter->bSpawnByRate = waves == NULL;
+	if (waves && waves->peakAlive > enemyEmitter->sys->capacity) {
+		enemyEmitter->setCapacity(waves->peakAlive);
+	}
+	if (waves) enemyEmitter->sys->preallocate(waves->peakAlive);
+	enemyEmitter->start();
+
+	//the player sprite to chase
+	//
+	player->bHighlight = true;
+	player->pos = glm::vec3(width / 2, height / 2, 0);
+	player->savePrevious();     // don't blend in from the last game's position
+	if (player->bShowImage == false) {
+		player->setHeight(abs(player->verts[0].y) + abs(player->verts[2].y));
+		player->setWidth(abs(player->verts[0].x) + abs(player->verts[1].x));
+	}
+
+	//Set up the beam emitter and start it
+	beamEmitter->world = this;
+	beamEmitter->emitterType = playerFire;
+	beamEmitter->pos = player->pos;
+	beamEmitter->rot = player->rot;
+	beamEmitter->drawable = true;
+	beamEmitter->rate = 1;
+	beamEmitter->setNAgents(1);
+	beamEmitter->sys->rules.bBounce = true;
+	beamEmitter->start();
+}
+
+//Changes the settings. Only the groups that differ are marked dirty, and
+//the next step only pushes those to the emitters and the player, so a
+//step without changes writes no settings to any sprite
+void World::setSettings(const WorldSettings &s) {
+	WorldSettings &o = settings;
+	if (s.rate != o.rate || s.enemyLife != o.enemyLife || s.velocity != o.velocity || s.nAgents != o.nAgents) {
+		dirty |= dirtyEnemies;
+	}
+	if (s.scale != o.scale || s.rotationSpeed != o.rotationSpeed) {
+		dirty |= dirtyStyle;
+	}
+	if (s.playerScale != o.playerScale || s.playerRotationSpeed != o.playerRotationSpeed || s.playerMoveSpeed != o.playerMoveSpeed) {
+		dirty |= dirtyPlayer;
+	}
+	if (s.beamLife != o.beamLife || s.beamSpeed != o.beamSpeed) {
+		dirty |= dirtyBeams;
+	}
+	settings = s;
+}
+
+//Moves the enemies on n threads, 0 for one per hardware thread, 1 for
+//the main thread only. Threaded and serial runs give the same results,
+//each enemy only reads the player and writes itself.
+void World::setThreads(int n) {
+	if (n == 1) {
+		jobs.stop();
+		enemyEmitter->jobs = NULL;
+		return;
+	}
+	jobs.start(n);
+	enemyEmitter->jobs = &jobs;
+}
+
+//The collisions, systems and drawing only read SpriteList::sprites, the
+//structOfArrays storage is for the benchmarks (see SpriteList)
+void World::assertSpriteStorage() {
+	for (int e = 0; e < emitters.size(); e++) {
+		assert(emitters[e]->sys->storage == arrayOfSprites);
+	}
+}
+
+//Current simulation time in ms
+float World::time() {
+	return clock->now();
+}
+
+//Random number from the world's own generator, so a seed repeats a run
+float World::random(float min, float max) {
+	std::uniform_real_distribution<float> dist(min, max);
+	return dist(rng);
+}
+
+//Runs as many fixed steps of stepDt as fit in the time since the last
+//frame (frameTime, seconds). Leftover time carries over to the next
+//frame. At most maxSubSteps are run, so a slow frame can't snowball into
+//ever more steps; the time beyond that is dropped.
+//Returns how far (0..1) the frame is into the next step, for drawing.
+//--------------------------------------------------------------
+float World::advance(float frameTime) {
+	accumulator += frameTime;
+	int steps = 0;
+	while (accumulator >= stepDt && steps < maxSubSteps) {
+		step(stepDt);
+		accumulator -= stepDt;
+		steps++;
+	}
+	if (accumulator >= stepDt) {
+		accumulator = fmod(accumulator, stepDt);
+	}
+	return accumulator / stepDt;
+}
+
+//Advances the simulation by dt seconds. The player moves first, then the
+//emitters spawn, expire and move their sprites, the shared systems run
+//over every sprite list, the explosion particles move and last the
+//collisions remove what was hit
+//--------------------------------------------------------------
+void World::step(float dt) {
+	PROFILE_ZONE("World::step");
+	assertSpriteStorage();
+	if (recorder) recorder->step(*this);
+	player->savePrevious();
+	enemyEmitter->sys->savePrevious();
+	beamEmitter->sys->savePrevious();
+	clock->advance(dt);
+	updateControls();
+	updatePlayer(dt);
+	updateBeamEmitter(dt);
+	updateEnemyEmitter(dt);
+	runSystems(dt);
+	explosions.update(time(), dt);
+
+	//Remove each enemy hit by a beam, then each enemy that hit the player.
+	//Both use the same grid of the enemies, built once after they moved
+	//(again only if a beam removed some)
+	collideBeams();
+	explodeEnemies(collisionHits);
+	collidePlayer();
+	explodeEnemies(collisionHits);
+	stepCount++;
+	dirty = 0;
+	clearScratch();
+}
+
+//Frees the scratch memory of a step (collision pairs and hits). The next
+//collision check builds the grid again
+void World::clearScratch() {
+	bGridBuilt = false;
+	collisionPairs.clear();
+	collisionHits.clear();
+	frameArena.reset();
+}
+
+//Fires a beam from the player
+void World::fire() {
+	if (recorder) recorder->fire(*this);
+	beamEmitter->spawnSprite();
+	beamEmitter->bBeam = true;
+}
+
+//--------------------------------------------------------------
+//Applies player input
+void World::updateControls() {
+	player->bEngine = controls.up || controls.down || controls.left || controls.right;
+	if (controls.up) {
+		player->addForces(player->moveSpeed * player->heading());
+	}
+	if (controls.down) {
+		player->addForces(-player->moveSpeed * player->heading());
+	}
+	if (controls.left) {
+		player->addAngularForces(-settings.playerRotationSpeed);
+	}
+	if (controls.right) {
+		player->addAngularForces(settings.playerRotationSpeed);
+	}
+}
+
+//--------------------------------------------------------------
+//Update player values
+void World::updatePlayer(float dt) {
+	player->integrate(dt);
+	if (dirty & dirtyPlayer) {
+		player->setRotationSpeed(settings.playerRotationSpeed);
+		player->setMoveSpeed(settings.playerMoveSpeed);
+		player->setScale(settings.playerScale);
+	}
+	player->update();
+	checkBorder(*player);
+	if (player->nEnergy == 0) {
+		bGameOver = true;
+	}
+}
+
+//--------------------------------------------------------------
+//Updates beamEmitter. It follows the player every step, the settings are
+//only pushed when they changed
+void World::updateBeamEmitter(float dt) {
+	PROFILE_ZONE("World::updateBeamEmitter");
+	beamEmitter->pos = player->pos;
+	beamEmitter->rot = player->rot;
+	beamEmitter->setVelocity(player->heading() * int (settings.beamSpeed));
+	if (dirty & dirtyBeams) {
+		beamEmitter->setLifespan(settings.beamLife);
+	}
+	if (dirty & dirtyStyle) {
+		beamEmitter->sys->rules.setStyle(settings.scale, settings.rotationSpeed);
+	}
+	beamEmitter->update(dt);
+}
+
+//--------------------------------------------------------------
+//Check Collision for each enemy and beam. The grid only hands back
+//beam/enemy pairs whose moves in this step came close to each other. A
+//pair hits if they overlap now or the beam passed through the enemy
+//during the step (see sweptCollision), so fast beams don't go through
+//enemies between steps. The hit enemies are left in collisionHits,
+//returns how many pairs hit
+int World::collideBeams() {
+	PROFILE_ZONE("World::collideBeams");
+	vector<Sprite> &beams = beamEmitter->sys->sprites;
+	vector<Sprite> &enemies = enemyEmitter->sys->sprites;
+	buildCollisionGrid();
+	collisionGrid.resetCounters();
+	collisionPairs.clear();
+	collisionGrid.query(beams, collisionPairs);
+	nBeamRejected = collisionGrid.nRejected;
+	collisionHits.clear();
+	for (int i = 0; i < collisionPairs.size(); i++) {
+		CollisionPair &p = collisionPairs[i];
+		if (checkCollision(beams[p.a], enemies[p.b]) || sweptCollision(beams[p.a], enemies[p.b])) {
+			collisionHits.push_back(p.b);
+			//player->increaseEnergy(1);
+		}
+	}
+	return collisionHits.size();
+}
+
+//--------------------------------------------------------------
+//Update enemyEmitter values
+void World::updateEnemyEmitter(float dt) {
+	PROFILE_ZONE("World::updateEnemyEmitter");
+	if (dirty & dirtyEnemies) {
+		enemyEmitter->setRate(settings.rate);
+		enemyEmitter->setLifespan(settings.enemyLife);
+		enemyEmitter->setVelocity(settings.velocity);
+		enemyEmitter->setNAgents(settings.nAgents);
+	}
+	if (dirty & dirtyStyle) {
+		enemyEmitter->sys->rules.setStyle(settings.scale, settings.rotationSpeed);
+	}
+	if (waves) spawnWaves();
+	enemyEmitter->update(dt);
+}
+
+//--------------------------------------------------------------
+//Builds the grid of the enemies, unless it is still up to date: it is
+//built once a step and only built again after enemies were removed
+void World::buildCollisionGrid() {
+	if (bGridBuilt) return;
+	collisionGrid.build(enemyEmitter->sys->sprites);
+	bGridBuilt = true;
+}
+
+//--------------------------------------------------------------
+//Check Collision for each enemy near the player. Each hit costs the
+//player energy, the hit enemies are left in collisionHits
+int World::collidePlayer() {
+	PROFILE_ZONE("World::collidePlayer");
+	vector<Sprite> &enemies = enemyEmitter->sys->sprites;
+	buildCollisionGrid();
+	collisionGrid.resetCounters();
+	collisionPairs.clear();
+	collisionGrid.query(*player, 0, collisionPairs);
+	nPlayerRejected = collisionGrid.nRejected;
+	collisionHits.clear();
+	for (int i = 0; i < collisionPairs.size(); i++) {
+		if (checkCollision(enemies[collisionPairs[i].b], *player)) {
+			collisionHits.push_back(collisionPairs[i].b);
+			player->decreaseEnergy(1);
+		}
+	}
+	return collisionHits.size();
+}
+
+//--------------------------------------------------------------
+//Spawns every wave event that is due by now, in time order. The events
+//are sorted, so this only looks past the ones it spawns
+void World::spawnWaves() {
+	PROFILE_ZONE("World::spawnWaves");
+	float now = time();
+	while (nextWave < waves->events.size() && waves->events[nextWave].time <= now) {
+		enemyEmitter->spawnBurst(waves->events[nextWave]);
+		nextWave++;
+	}
+}
+
+//--------------------------------------------------------------
+//Spawns an explosion at each hit enemy and removes it.
+//Hits are removed from the back so the remaining indices stay valid
+void World::explodeEnemies(FrameVector<int> &hits) {
+	sort(hits.begin(), hits.end());
+	hits.resize(unique(hits.begin(), hits.end()) - hits.begin());
+	if (hits.size() > 0) bGridBuilt = false;   // the indices moved
+	for (int i = hits.size() - 1; i >= 0; i--) {
+		explode(enemyEmitter->sys->sprites[hits[i]].pos);
+		nExplosions++;
+		enemyEmitter->sys->remove(hits[i]);
+	}
+}
+
+//--------------------------------------------------------------
+//Adds the particles of one explosion at pos: nParticles fragments flying
+//off in random directions, yellow to orange
+void World::explode(glm::vec3 pos) {
+	float now = time();
+	for (int i = 0; i < nParticles; i++) {
+		glm::vec3 p(pos.x + random(-10, 10), pos.y + random(-10, 10), 0);
+		glm::vec3 v(random(-particleSpeed, particleSpeed), random(-particleSpeed, particleSpeed), 0);
+		explosions.add(p, v, now, ofFloatColor(1, random(.4, 1), random(0, .3)));
+	}
+}
+
+//--------------------------------------------------------------
+//Runs each shared system over the sprites of every emitter, in a fixed
+//order. Each system is one loop that only does its own job, split into
+//chunks on the emitter's job system (see Emitter::forEachChunk); every
+//sprite only writes itself, so a threaded run matches a serial one.
+void World::runSystems(float dt) {
+	PROFILE_ZONE("World::runSystems");
+	styleSystem();
+	borderSystem();
+}
+
+//Applies the scale and rotation speed from the settings, only to the lists
+//whose style changed since the last step
+void World::styleSystem() {
+	for (int e = 0; e < emitters.size(); e++) {
+		SpriteList *sys = emitters[e]->sys;
+		SpriteRules &rules = sys->rules;
+		if (!rules.bStyle || !rules.bChanged) continue;
+		rules.bChanged = false;
+		rules.style(sys->archetype);
+		emitters[e]->forEachChunk(sys->sprites.size(), [&](int begin, int end) {
+			for (int i = begin; i < end; i++) {
+				rules.style(sys->sprites[i]);
+			}
+		});
+	}
+}
+
+//Bounces the sprites off the arena border (beams)
+void World::borderSystem() {
+	for (int e = 0; e < emitters.size(); e++) {
+		SpriteList *sys = emitters[e]->sys;
+		if (!sys->rules.bBounce) continue;
+		emitters[e]->forEachChunk(sys->sprites.size(), [&](int begin, int end) {
+			for (int i = begin; i < end; i++) {
+				checkBorder(sys->sprites[i]);
+			}
+		});
+	}
+}
+
+//--------------------------------------------------------------
+//Checks if sprite collided with another sprite. Two image sprites are
+//tested by overlapping the opaque pixels of their masks, otherwise the
+//corners of each sprite are tested against the other
+bool World::checkCollision(Sprite &s1, Sprite &s2) {
+	if (s1.bShowImage && s2.bShowImage && s1.mask && s2.mask) {
+		glm::mat4 toS2 = s2.getInverseTransform() * s1.getTransform();
+		glm::mat4 toS1 = s1.getInverseTransform() * s2.getTransform();
+		return s1.mask->overlaps(*s2.mask, toS2, toS1);
+	}
+	for (int i = 0; i < 3; i++) {
+		glm::vec3 sVert = s1.toWorld(s1.verts[i]);
+		glm::vec3 tVert = s2.toWorld(s2.verts[i]);
+		if (s2.insidePoint(sVert) || s1.insidePoint(tVert)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+//Squared distance from p to the segment a-b (z ignored)
+static float segmentDistance2(glm::vec3 p, glm::vec3 a, glm::vec3 b) {
+	glm::vec3 ab = b - a;
+	float len2 = ab.x * ab.x + ab.y * ab.y;
+	float t = len2 > 0 ? ofClamp(((p.x - a.x) * ab.x + (p.y - a.y) * ab.y) / len2, 0, 1) : 0;
+	float x = a.x + ab.x * t - p.x;
+	float y = a.y + ab.y * t - p.y;
+	return x * x + y * y;
+}
+
+static float cross2(glm::vec3 a, glm::vec3 b) {
+	return a.x * b.y - a.y * b.x;
+}
+
+//True if the segments p0-p1 and q0-q1 cross. Parallel segments don't,
+//the distance test in pathNearTriangle covers them
+static bool segmentsCross(glm::vec3 p0, glm::vec3 p1, glm::vec3 q0, glm::vec3 q1) {
+	glm::vec3 r = p1 - p0;
+	glm::vec3 q = q1 - q0;
+	float den = cross2(r, q);
+	if (den == 0) return false;
+	float t = cross2(q0 - p0, q) / den;
+	float u = cross2(q0 - p0, r) / den;
+	return t >= 0 && t <= 1 && u >= 0 && u <= 1;
+}
+
+//True if the path a to a + d comes within rl of the triangle v, all in
+//the triangle's object space: it starts inside, crosses an edge or passes
+//an edge closer than rl
+static bool pathNearTriangle(glm::vec3 a, glm::vec3 d, const vector<glm::vec3> &v, float rl) {
+	glm::vec3 b = a + d;
+	float rl2 = rl * rl;
+	float c0 = cross2(v[1] - v[0], a - v[0]);
+	float c1 = cross2(v[2] - v[1], a - v[1]);
+	float c2 = cross2(v[0] - v[2], a - v[2]);
+	if ((c0 >= 0 && c1 >= 0 && c2 >= 0) || (c0 <= 0 && c1 <= 0 && c2 <= 0)) return true;
+	for (int i = 0; i < 3; i++) {
+		glm::vec3 e0 = v[i];
+		glm::vec3 e1 = v[(i + 1) % 3];
+		if (segmentsCross(a, b, e0, e1)) return true;
+		if (segmentDistance2(e0, a, b) <= rl2 || segmentDistance2(a, e0, e1) <= rl2 ||
+			segmentDistance2(b, e0, e1) <= rl2) {
+			return true;
+		}
+	}
+	return false;
+}
+
+//--------------------------------------------------------------
+//Checks if sprite s1 passed through sprite s2 during the last step. s1's
+//path (prevPos to pos, less s2's own move) is taken into s2's object
+//space. A triangle sprite is hit if the path comes within s1's radius of
+//the triangle. Otherwise the path is clipped against s2's box grown by
+//s1's radius, and if s2 has a mask, the part of the path inside the box is
+//walked a pixel at a time for an opaque pixel. The cost doesn't depend on
+//how far s1 moved.
+//A move shorter than s1's radius can't skip over s2, checkCollision at
+//the end position covers it
+bool World::sweptCollision(Sprite &s1, Sprite &s2) {
+	float r = 0.5 * MIN(s1.width * fabs(s1.scale.x), s1.height * fabs(s1.scale.y));
+	glm::vec3 start = s1.prevPos + (s2.pos - s2.prevPos);
+	glm::vec3 move = s1.pos - start;
+	move.z = 0;
+	if (glm::dot(move, move) <= r * r) return false;
+
+	glm::vec3 a = s2.toObject(start);
+	glm::vec3 d = s2.toObject(s1.pos) - a;
+	a.z = 0;
+	d.z = 0;
+	// the radius in object space, the larger one if s2 is scaled unevenly
+	float rl = r / MIN(fabs(s2.scale.x), fabs(s2.scale.y));
+	if (!s2.bShowImage) return pathNearTriangle(a, d, s2.verts, rl);
+
+	float half[2] = { s2.width / 2 + rl, s2.height / 2 + rl };
+	float t0 = 0;
+	float t1 = 1;
+	for (int k = 0; k < 2; k++) {
+		if (fabs(d[k]) < 1e-6) {
+			if (a[k] < -half[k] || a[k] > half[k]) return false;
+			continue;
+		}
+		float tNear = (-half[k] - a[k]) / d[k];
+		float tFar = (half[k] - a[k]) / d[k];
+		if (tNear > tFar) std::swap(tNear, tFar);
+		t0 = MAX(t0, tNear);
+		t1 = MIN(t1, tFar);
+		if (!(t0 <= t1)) return false;     // also false for a NaN path
+	}
+	if (!s2.mask) return true;
+
+	glm::vec3 p = a + d * t0;
+	float len = glm::length(d) * (t1 - t0);
+	int n = ceil(len);
+	glm::vec3 step = n > 0 ? d * ((t1 - t0) / n) : glm::vec3(0);
+	for (int i = 0; i <= n; i++) {
+		if (s2.mask->testLocal(p)) return true;
+		p += step;
+	}
+	return false;
+}
+
+//--------------------------------------------------------------
+//Checks if temperary sprite pos is outside the arena border
+//Uses +- height to get the full image size
+//Bounces sprite off of the border
+void World::checkBorder(Sprite &s) {
+	float x = s.pos.x;
+	float y = s.pos.y;
+	float height = s.height;
+	float width = s.width;
+	if (x - width / 2 < 0 || x + width / 2 > this->width) {
+		s.setVelocity(glm::vec3(-2 * s.velocity.x, s.velocity.y, 0));
+	}
+	else if (y - height / 2 < 0 || y + height / 2 > this->height) {
+		s.setVelocity(glm::vec3(s.velocity.x, -2 * s.velocity.y, 0));
+	}
+}
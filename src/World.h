@@ -0,0 +1,134 @@
+#pragma once
+
+#include "ofMain.h"
+#include "Clock.h"
+#include "Emitter.h"
+#include "AgentEmitter.h"
+#include "Sprite.h"
+#include "SpatialGrid.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include "FrameArena.h"
+#include "WaveSchedule.h"
+#include "ParticleBuffer.h"
+
+class ReplayRecorder;
+
+//  Values the game takes from the GUI sliders. The defaults are the
+//  "normal" difficulty settings.
+//
+struct WorldSettings {
+	float rate = 1;                 // enemies/sec
+	float enemyLife = 5000;         // ms
+	glm::vec3 velocity = glm::vec3(150, 150, 0);
+	int nAgents = 1;
+	float scale = .8;
+	float rotationSpeed = 3;        // deg/frame
+	float playerScale = 1;
+	float playerRotationSpeed = 500;
+	int playerMoveSpeed = 1500;
+	float beamLife = 2000;          // ms
+	float beamSpeed = 1500;         // px/sec
+};
+
+//  Groups of WorldSettings, one bit each in World::dirty
+//
+enum settingsGroup {
+	dirtyEnemies = 1,       // rate, enemyLife, velocity, nAgents
+	dirtyStyle = 2,         // scale, rotationSpeed
+	dirtyPlayer = 4,        // playerScale, playerRotationSpeed, playerMoveSpeed
+	dirtyBeams = 8,         // beamLife, beamSpeed
+	dirtyAll = 15
+};
+
+//  Player input for one step
+//
+struct WorldControls {
+	bool up = false;
+	bool down = false;
+	bool left = false;
+	bool right = false;
+};
+
+//  The game simulation: owns the emitters and the player and runs the
+//  movement, collision and border logic. It does not draw, play sounds or
+//  read the window, so it can run without a window or GL context.  Time,
+//  random numbers and the arena size come from setup().
+//
+class World {
+public:
+	World();
+	~World();
+	void setup(Clock *clock, unsigned int seed, float width, float height);
+	void setSettings(const WorldSettings &s);
+	float advance(float frameTime);
+	void step(float dt);
+	void fire();
+	void explode(glm::vec3 pos);
+	int collideBeams();
+	int collidePlayer();
+	void clearScratch();
+	void setThreads(int n);
+
+	float time();
+	float random(float min, float max);
+
+	bool checkCollision(Sprite &s1, Sprite &s2);
+	bool sweptCollision(Sprite &s1, Sprite &s2);
+	void checkBorder(Sprite &s);
+
+	Emitter *enemyEmitter = NULL;
+	Emitter *beamEmitter = NULL;
+	Sprite *player = NULL;
+	vector<Emitter *> emitters;     // the two above, in the order they update
+
+	ParticleBuffer explosions;      // fragments of exploded enemies
+	int nParticles = 10;            // per explosion
+	float particleSpeed = 300;      // px/sec, most a fragment starts with
+
+	WorldSettings settings;     // change with setSettings
+	int dirty = dirtyAll;       // settingsGroups changed since the last step
+	WorldControls controls;
+	bool bGameOver;
+	float width, height;
+
+	// fixed step simulation (see advance)
+	float stepDt = 1.0 / 60;
+	int maxSubSteps = 5;
+	float accumulator = 0;
+
+	SpatialGrid collisionGrid;
+	int nBeamRejected = 0;      // beam/enemy pairs the grid ruled out last step
+	int nPlayerRejected = 0;    // player/enemy pairs the grid ruled out last step
+	FrameArena frameArena;  // scratch memory for one step, reset after it
+	JobSystem jobs;         // moves the enemies in parallel (see setThreads)
+
+	unsigned int seed;
+	int stepCount = 0;      // steps run since setup
+	int nExplosions = 0;    // enemies exploded since setup
+	ReplayRecorder *recorder = NULL;   // if set, logs the inputs of each step
+
+	// if set before setup, the enemies come from this schedule instead of
+	// settings.rate/nAgents/enemyLife/velocity (see spawnWaves)
+	WaveSchedule *waves = NULL;
+	int nextWave = 0;       // next event of waves to spawn
+
+private:
+	void assertSpriteStorage();
+	void updateControls();
+	void updatePlayer(float dt);
+	void updateEnemyEmitter(float dt);
+	void spawnWaves();
+	void runSystems(float dt);
+	void styleSystem();
+	void borderSystem();
+	void updateBeamEmitter(float dt);
+	void explodeEnemies(FrameVector<int> &hits);
+	void buildCollisionGrid();
+
+	Clock *clock;
+	std::mt19937 rng;
+	FrameVector<CollisionPair> collisionPairs;     // scratch from frameArena
+	FrameVector<int> collisionHits;
+	bool bGridBuilt = false;    // collisionGrid holds the enemies as they are
+};
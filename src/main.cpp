@@ -1,12 +1,23 @@
 #include "ofMain.h"
 #include "ofApp.h"
+#include "Replay.h"
 
 //========================================================================
-int main( ){
+int main(int argc, char *argv[]){
+	// "--replay file" plays a recorded game back headless
+	if (argc > 1 && string(argv[1]) == "--replay") {
+		return runReplay(argc, argv);
+	}
+
 	ofSetupOpenGL(1280,1024,OF_WINDOW);			// <-------- setup the GL context
 
 	// this kicks off the running of my app
 	// can be OF_WINDOW or OF_FULLSCREEN
 	// pass in width and height too:
-	ofRunApp(new ofApp());
+	ofApp *app = new ofApp();
+	// "--waves file" spawns the enemies from another wave file in bin/data
+	if (argc > 2 && string(argv[1]) == "--waves") {
+		app->waveFile = argv[2];
+	}
+	ofRunApp(app);
 }
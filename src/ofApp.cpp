@@ -1,92 +1,5 @@
 #include "ofApp.h"
 
-// spawnSprite - we override this function in the Emitter class to spawn our 
-// "custom" Agent sprite.
-//
-void AgentEmitter::spawnSprite() {
-	for (int i = 0; i < nAgents; i++) {
-		Agent sprite;
-		if (haveChildImage) {
-			sprite.setImage(childImage);
-		}
-		else {
-			sprite.bHighlight = true;
-			sprite.setHeight(abs(sprite.verts[0].y) + abs(sprite.verts[2].y));
-			sprite.setWidth(abs(sprite.verts[0].x) + abs(sprite.verts[1].x));
-		}
-		sprite.velocity = velocity;
-		sprite.lifespan = lifespan;
-		switch (emitterType) {
-		case enemySpawner:
-			sprite.pos = glm::vec3(ofRandom(0, ofGetScreenWidth()), ofRandom(0, ofGetScreenHeight()), 0);
-			sprite.rot = ofRandom(0, 360);
-			sprite.birthtime = ofGetElapsedTimeMillis();
-			sys->add(sprite);
-			break;
-		case playerFire:
-			sprite.pos = pos;
-			sprite.rot = rot;
-			sprite.birthtime = ofGetElapsedTimeMillis();
-			if (sprite.birthtime - lastSpawned > 1000) {
-				lastSpawned = sprite.birthtime;
-				sys->add(sprite);
-			}
-			break;
-		case explosion:
-			sprite.pos = glm::vec3(pos.x + ofRandom(-10,10), pos.y + ofRandom(-10, 10), 0);
-			sprite.rot = rot;
-			sprite.addForces(glm::vec3(ofRandom(-10000, 10000), ofRandom(-10000, 10000), 0));
-			sprite.birthtime = ofGetElapsedTimeMillis();
-			sys->add(sprite);
-			break;
-		}
-	}
-}
-
-//  moveSprite - we override this function in the Emitter class to implment
-//  "following" motion towards the player
-//
-void AgentEmitter::moveSprite(Sprite* sprite) {
-
-	// Get a pointer to the app so we can access application
-	// data such as the player sprite.
-	//
-	ofApp* theApp = (ofApp*)ofGetAppPtr();
-
-	// rotate sprite to point towards player
-	//  - find vector "v" from sprite to player
-	//  - set rotation of sprite to align with v
-	//
-
-	glm::vec3 v = glm::normalize(theApp->player->pos - sprite->pos);
-	glm::vec3 h = sprite->heading();
-	float dotp = glm::dot(h, v);
-	float eps = .0005;
-	float sp = sprite->rotationSpeed;
-	glm::vec3 crossp = glm::cross(h, v);
-	switch (emitterType) {
-	case enemySpawner:
-		if (dotp < (1.0 - eps)) {
-			if (crossp.z > 0.0) {
-				sprite->rot += sp;
-			}
-			else {
-				sprite->rot -= sp;
-			}
-		}
-		sprite->addForces(500 * v);
-		sprite->integrate();
-		break;
-	}
-
-	// Calculate new velocity vector
-	// with same speed (magnitude) as the old one but in direction of "v"
-	// 	
-	// Now move the sprite in the normal way (along velocity vector)
-	//
-	Emitter::moveSprite(sprite);
-}
-
 //--------------------------------------------------------------
 void ofApp::setup(){
 
@@ -96,86 +9,85 @@ void ofApp::setup(){
 	dif = normal;
 	toggleSprites = true;
 	ofResetElapsedTimeCounter();
-	setupVisuals();
 	setupGui(dif);
-	setupObjects();
 	ofSetFullscreen(true);
-	gameState = ready;
+	gameState = loading;
+	startLoading();
 }
 
-//Setups visuals and sounds
+//Starts loading the images in the background. update() shows the loading
+//screen until they are done, then sets up the game. Images are only read
+//from disk the first time, restarts reuse them. The sounds are loaded once,
+//on the audio thread when it starts (see AudioSystem)
+void ofApp::startLoading() {
+	loader.addImage("images/Missile2.png");
+	loader.addImage("images/Beam.png");
+	loader.addImage("images/Background1.png");
+	if (!bSoundsLoaded) {
+		audio.load(soundBeam, "sounds/beam.wav", true, .2);
+		audio.load(soundEngine, "sounds/engine.wav", true, .5);
+		audio.load(soundExplosion, "sounds/explosion.wav", false, .2, 4);
+		bSoundsLoaded = true;
+	}
+	if (waves.path != waveFile) {
+		loader.addTask([this]() {
+			if (!waves.load(waveFile)) cout << "Can't open wave file " << waveFile << endl;
+		});
+	}
+	loader.start(&images);
+}
+
+//Setups visuals and sounds once the assets are loaded
 void ofApp::setupVisuals() {
-	if (enemyImage.load("images/Missile2.png") && toggleSprites == true) {
+	enemyImage = images.find("images/Missile2.png");
+	beamImage = images.find("images/Beam.png");
+	background = images.find("images/Background1.png");
+	if (enemyImage && toggleSprites == true) {
 		enemyLoaded = true;
 	}
 	else {
 		enemyLoaded = false;
 		cout << "Can't open image file" << endl;
 	}
-	if (beamImage.load("images/Beam.png") && toggleSprites == true) {
+	if (beamImage && toggleSprites == true) {
 		beamLoaded = true;
 	}
 	else {
 		beamLoaded = false;
 		cout << "Can't open image file" << endl;
 	}
-	if (background.load("images/Background1.png")) {
+	if (background) {
 		backgroundLoaded = true;
 	}
 	else {
+		backgroundLoaded = false;
 		cout << "Can't open background image file" << endl;
 	}
-	beamSound.load("sounds/beam.wav");
-	beamSound.setLoop(true);
-	beamSound.setVolume(.2);
-	engineSound.load("sounds/engine.wav");
-	engineSound.setLoop(true);
-	engineSound.setVolume(.5);
-	explosionSound.load("sounds/explosion.wav");
-	explosionSound.setLoop(true);
-	explosionSound.setVolume(.2);
+	//The audio thread keeps running across restarts
+	audio.start();
 }
 
-//Creates enemy, explosion, and beam emitter along with player
+//Creates the world (enemy and beam emitter along with player)
+//and gives the emitters their images. The enemies come from the wave file,
+//scaled by the difficulty, or from the sliders if it is off or missing
 //--------------------------------------------------------------
 void ofApp::setupObjects() {
-	//Create enemy emitter and start it
-	enemyEmitter = new AgentEmitter();  // C++ polymorphism
-	enemyEmitter->emitterType = enemySpawner;
-	enemyEmitter->pos = glm::vec3(ofGetWindowWidth() / 2.0, ofGetWindowHeight() / 2.0, 0);
-	enemyEmitter->drawable = true;
+	recorder.stop(world);
+	world.waves = NULL;
+	if (bWaves && waves.size() > 0) {
+		waves.build(float(dif) / 10);
+		world.waves = &waves;
+	}
+	world.setup(&clock, ofRandom(0, 1 << 30), ofGetScreenWidth(), ofGetScreenHeight());
+	world.setThreads(0);
 	if (enemyLoaded && toggleSprites) {
-		enemyEmitter->setChildImage(enemyImage);
-	}
-	enemyEmitter->start();
-
-	//create a player sprite to chase
-	//
-	player = new Sprite();
-	player->bHighlight = true;
-	player->pos = glm::vec3(ofGetScreenWidth() / 2, ofGetScreenHeight() / 2, 0);
-	if (player->bShowImage == false) {
-		player->setHeight(abs(player->verts[0].y) + abs(player->verts[2].y));
-		player->setWidth(abs(player->verts[0].x) + abs(player->verts[1].x));
+		world.enemyEmitter->setChildImage(enemyImage, images.getMask(enemyImage));
 	}
-
-	//Create beam emitter and start it
-	beamEmitter = new AgentEmitter();
-	beamEmitter->emitterType = playerFire;
-	beamEmitter->pos = player->pos;
-	beamEmitter->rot = player->rot;
-	beamEmitter->drawable = true;
 	if (beamLoaded && toggleSprites) {
-		beamEmitter->setChildImage(beamImage);
+		world.beamEmitter->setChildImage(beamImage, images.getMask(beamImage));
 	}
-	beamEmitter->start();
-
-	//Create explosion emitter and start it
-	explosionEmitter = new AgentEmitter();
-	explosionEmitter->emitterType = explosion;
-	explosionEmitter->pos = glm::vec3(500, 500, 0);
-	explosionEmitter->drawable = true;
-	explosionEmitter->start();
+	world.enemyEmitter->sys->bBatch = bBatchDraw;
+	world.beamEmitter->sys->bBatch = bBatchDraw;
 }
 
 //--------------------------------------------------------------
@@ -201,217 +113,156 @@ void ofApp::setupGui(difficulty dif) {
 	gui.add(beamLife.setup("Beam Life", 2, .1, 10));
 	gui.add(beamSpeed.setup("Beam Speed", 1500, 100, 5000));
 
+	//The world only gets the slider values after one of them changed.
+	//This runs again on every difficulty change and restart, so each
+	//listener is removed before it is added and there is only ever one
+	listenToSlider<float>(rateOfSpawn);
+	listenToSlider<float>(enemyLife);
+	listenToSlider<ofDefaultVec3>(velocity);
+	listenToSlider<int>(nAgents);
+	listenToSlider<float>(scale);
+	listenToSlider<float>(rotationSpeed);
+	listenToSlider<int>(playerMoveSpeed);
+	listenToSlider<float>(playerRotationSpeed);
+	listenToSlider<float>(playerScale);
+	listenToSlider<float>(beamLife);
+	listenToSlider<float>(beamSpeed);
+	bSlidersChanged = true;
+
 	bHide = true;
 }
 
 //Updates the program by frame
 //--------------------------------------------------------------
 void ofApp::update() {
-	if (!gameState == playable) {
+	profiler().frame();
+	if (gameState == loading) {
+		if (loader.update()) {
+			setupVisuals();
+			setupObjects();
+			gameState = ready;
+		}
 		return;
 	}
-	updateKeyPressed();
-	updatePlayer();
-	updateBeamEmitter();
-	updateEnemyEmitter();
-	updateExplosionEmitter();
-
-}
-
-//--------------------------------------------------------------
-//Updates Keys
-void ofApp::updateKeyPressed() {  
-	if (keymap[OF_KEY_UP]) {
-		player->addForces(player->moveSpeed * player->heading());
-		player->bEngine = true;
-	}
-	if (keymap[OF_KEY_DOWN]) {
-		player->addForces(-player->moveSpeed * player->heading());
-		player->bEngine = true;
-
-	}
-	if (keymap[OF_KEY_LEFT]) {
-		player->addAngularForces(-playerRotationSpeed);
-		player->bEngine = true;
-	}
-	if (keymap[OF_KEY_RIGHT]) {
-		player->addAngularForces(playerRotationSpeed);
-		player->bEngine = true;
+	if (!gameState == playable) {
+		return;
 	}
-}
-
-//--------------------------------------------------------------
-//Update player values
-void ofApp::updatePlayer() {
-	player->integrate();
-	player->setRotationSpeed(playerRotationSpeed);
-	player->setMoveSpeed(playerMoveSpeed);
-	player->setScale(playerScale);
-	player->update();
-	checkBorder(*player);
-		//player->velocity = glm::vec3(-2 * player->velocity.x, player->velocity.y, 0);
-	if (player->nEnergy == 0) {
+	updateSettings();
+	renderAlpha = world.advance(ofGetLastFrameTime());
+	if (world.bGameOver) {
+		recorder.stop(world);
 		gameState = gameOver;
 		totalTime = ofGetElapsedTimeMillis() / 1000;
 	}
-	if (player->bEngine && !engineSound.isPlaying()) {
-		engineSound.play();
-	}
-	else if (!player->bEngine && engineSound.isPlaying()) {
-		engineSound.stop();
-	}
-}
-//--------------------------------------------------------------
-//Updates beamEmitter
-void ofApp::updateBeamEmitter() {
-	beamEmitter->pos = player->pos;
-	beamEmitter->rot = player->rot;
-	beamEmitter->rate = 1;
-	beamEmitter->setLifespan(beamLife * 1000);
-	beamEmitter->setVelocity(player->heading() * int (beamSpeed));
-	beamEmitter->setNAgents(1);
-	beamEmitter->update();
-	if (beamEmitter->bBeam && !beamSound.isPlaying()) {
-		beamTime = ofGetElapsedTimeMillis();
-		beamSound.play();
-	}
-	else if (!beamEmitter->bBeam && beamSound.isPlaying()) {
-		if (ofGetElapsedTimeMillis() - beamTime > 1000) {
-			beamSound.stop();
-		}
-	}
-	for (int i = 0; i < beamEmitter->sys->sprites.size(); i++) {
-		// Get values from sliders and update sprites dynamically
-		//
-		Sprite &s = beamEmitter->sys->sprites[i];
-		float sc = scale;
-		float rs = rotationSpeed;
-		s.scale = glm::vec3(sc, sc, sc);
-		s.setRotationSpeed(rs);
-		checkBorder(s);
-		//Check Collision for each enemy and beam, remove if collided
-		for (int j = 0; j < enemyEmitter->sys->sprites.size(); j++) {
-			if (checkCollision(s, enemyEmitter->sys->sprites[j])) {
-				explosionEmitter->pos = enemyEmitter->sys->sprites[j].pos;
-				explosionEmitter->spawnSprite();
-				enemyEmitter->sys->remove(j);
-				explosionEmitter->bExplosion = true;
-				//player->increaseEnergy(1);
-			}
-		}
-	}
+	updateSounds();
 }
 
 //--------------------------------------------------------------
-//Update enemyEmitter values
-void ofApp::updateEnemyEmitter() {
-	enemyEmitter->setRate(rateOfSpawn);
-	enemyEmitter->setLifespan(enemyLife * 1000);    // convert to milliseconds 
-	enemyEmitter->setVelocity(ofVec3f(velocity->x, velocity->y, velocity->z));
-	enemyEmitter->setNAgents(nAgents);
-	enemyEmitter->update();
-	for (int i = 0; i < enemyEmitter->sys->sprites.size(); i++) {
-		// Get values from sliders and update sprites dynamically
-		//
-		Sprite& s = enemyEmitter->sys->sprites[i];
-		float sc = scale;
-		float rs = rotationSpeed;
-		s.scale = glm::vec3(sc, sc, sc);
-		s.setRotationSpeed(rs);
-		if (checkCollision(s, *player)) {
-			explosionEmitter->pos = enemyEmitter->sys->sprites[i].pos;
-			explosionEmitter->spawnSprite();
-			explosionEmitter->bExplosion = true;
-			player->decreaseEnergy(1);
-			enemyEmitter->sys->remove(i);
-		}
-	}
-}
-//--------------------------------------------------------------
-//Updates explosionEmitter values
-void ofApp::updateExplosionEmitter() {
-	explosionEmitter->pos = player->pos;
-	explosionEmitter->rot = player->rot;
-	explosionEmitter->rate = 10;
-	explosionEmitter->setLifespan(1000);
-	explosionEmitter->setVelocity(glm::vec3(ofRandom(-5, 5), ofRandom(-5, 5), 0));
-	explosionEmitter->setNAgents(10);
-	explosionEmitter->update();
-	if (explosionEmitter->bExplosion && !explosionSound.isPlaying()) {
-			explosionTime = ofGetElapsedTimeMillis();
-			explosionSound.play();
-	}
-	else if (!explosionEmitter->bExplosion && explosionSound.isPlaying()) {
-			explosionSound.stop();
-	}
-	else if (explosionEmitter->bExplosion && explosionSound.isPlaying()) {
-		if (ofGetElapsedTimeMillis() - explosionTime > 1000)
-			explosionEmitter->bExplosion = false;
-	}
-	for (int i = 0; i < explosionEmitter->sys->sprites.size(); i++) {
-		// Get values from sliders and update sprites dynamically
-		//
-		Sprite& s = explosionEmitter->sys->sprites[i];
-		float sc = .3;
-		float rs = rotationSpeed;
-		s.scale = glm::vec3(sc, sc, sc);
-		s.setRotationSpeed(rs);
-		s.integrate();
-		//Check Collision for each enemy and beam, remove if collided
-	}
+//Copies the pressed keys into the world, and the slider values if one
+//was moved since the last frame (see onSliderChanged)
+void ofApp::updateSettings() {
+	world.controls.up = keymap[OF_KEY_UP];
+	world.controls.down = keymap[OF_KEY_DOWN];
+	world.controls.left = keymap[OF_KEY_LEFT];
+	world.controls.right = keymap[OF_KEY_RIGHT];
+	if (!bSlidersChanged) return;
+	bSlidersChanged = false;
+
+	WorldSettings s = world.settings;
+	s.rate = rateOfSpawn;
+	s.enemyLife = enemyLife * 1000;    // convert to milliseconds 
+	s.velocity = ofVec3f(velocity->x, velocity->y, velocity->z);
+	s.nAgents = nAgents;
+	s.scale = scale;
+	s.rotationSpeed = rotationSpeed;
+	s.playerScale = playerScale;
+	s.playerRotationSpeed = playerRotationSpeed;
+	s.playerMoveSpeed = playerMoveSpeed;
+	s.beamLife = beamLife * 1000;
+	s.beamSpeed = beamSpeed;
+	world.setSettings(s);
 }
 
 //--------------------------------------------------------------
-//Checks if sprite collided with another sprite
-bool ofApp::checkCollision(Sprite s1, Sprite s2) {
-	for (int i = 0; i < 3; i++) {
-		glm::vec3 sVert = s1.getTransform() * glm::vec4(s1.verts[i], 1.0f);
-		glm::vec3 tVert = s2.getTransform() * glm::vec4(s2.verts[i], 1.0f);
-		if (s2.insidePoint(sVert) || s1.insidePoint(tVert)) {
-			return true;
+//Starts and stops the engine, beam and explosion sounds
+//Sends sound events to the audio thread when the game state changes.
+//Only the state the game asked for is checked here, never the players,
+//so this costs a few queue pushes at most
+void ofApp::updateSounds() {
+	if (world.player->bEngine != bEngineSound) {
+		bEngineSound = world.player->bEngine;
+		if (bEngineSound) audio.play(soundEngine);
+		else audio.stop(soundEngine);
+	}
+
+	if (world.beamEmitter->bBeam && !bBeamSound) {
+		beamTime = ofGetElapsedTimeMillis();
+		bBeamSound = true;
+		audio.play(soundBeam);
+	}
+	else if (!world.beamEmitter->bBeam && bBeamSound) {
+		if (ofGetElapsedTimeMillis() - beamTime > beamInterval) {
+			bBeamSound = false;
+			audio.stop(soundBeam);
 		}
 	}
-	return false;
-}
 
-//--------------------------------------------------------------
-//Checks if temperary sprite pos is outside screen border
-//Uses +- height to get the full image size
-//Bounces sprite off of the border
-void ofApp::checkBorder(Sprite &s) {
-	float x = s.pos.x;
-	float y = s.pos.y;
-	float height = s.height;
-	float width = s.width;
-	if (x - width / 2 < 0 || x + width / 2 > ofGetScreenWidth()) {
-		s.setVelocity(glm::vec3(-2 * s.velocity.x, s.velocity.y, 0));
-	}
-	else if (y - height / 2 < 0 || y + height / 2 > ofGetScreenHeight()) {
-		s.setVelocity(glm::vec3(s.velocity.x, -2 * s.velocity.y, 0));
+	//One explosion sound per exploded enemy, a restart starts the count over
+	if (world.nExplosions < explosionsHeard) explosionsHeard = 0;
+	int n = MIN(world.nExplosions - explosionsHeard, 4);
+	for (int i = 0; i < n; i++) {
+		audio.play(soundExplosion);
 	}
+	explosionsHeard = world.nExplosions;
 }
 
 //--------------------------------------------------------------
 //Draws App
 void ofApp::draw() {
+	PROFILE_ZONE("ofApp::draw");
 	ofSetColor(ofColor::white);
 	if (gameState == playable) {
 		if (backgroundLoaded) {
-			background.draw(0,0);
+			background->draw(0,0);
 		}
-		enemyEmitter->draw();
-		beamEmitter->draw();
-		explosionEmitter->draw();
+		world.enemyEmitter->draw(renderAlpha);
+		world.beamEmitter->draw(renderAlpha);
+		world.explosions.draw(renderAlpha);
 		ofSetColor(ofColor::aqua);
-		ofDrawLine(player->pos, player->pos + player->heading() * glm::vec3(3000, 3000, 0));
+		ofDrawLine(world.player->pos, world.player->pos + world.player->heading() * glm::vec3(3000, 3000, 0));
 		ofSetColor(ofColor::white);
-		player->draw();
+		world.player->draw(renderAlpha);
 		ofDrawBitmapString("nEnergy = ", ofGetScreenWidth() - 100, 25);
-		ofDrawBitmapString(player->nEnergy, ofGetScreenWidth() - 20, 25);
+		ofDrawBitmapString(world.player->nEnergy, ofGetScreenWidth() - 20, 25);
 		ofDrawBitmapString(ofGetFrameRate(), ofGetScreenWidth() - 100, 50);
+		int drawCalls = world.enemyEmitter->sys->drawCalls + world.beamEmitter->sys->drawCalls + world.explosions.drawCalls;
+		ofDrawBitmapString("draw calls = ", ofGetScreenWidth() - 330, 50);
+		ofDrawBitmapString(drawCalls, ofGetScreenWidth() - 220, 50);
 		ofDrawBitmapString(ofGetElapsedTimeMillis() / 1000, ofGetScreenWidth() - 100, 75);
+		ofDrawBitmapString("rejected beams/player = ", ofGetScreenWidth() - 300, 100);
+		ofDrawBitmapString(ofToString(world.nBeamRejected) + " / " + ofToString(world.nPlayerRejected), ofGetScreenWidth() - 100, 100);
+		ofDrawBitmapString("image KB = ", ofGetScreenWidth() - 200, 125);
+		ofDrawBitmapString(images.residentBytes() / 1024, ofGetScreenWidth() - 100, 125);
+		PoolStats &pool = world.enemyEmitter->sys->stats;
+		ofDrawBitmapString("pool reused = ", ofGetScreenWidth() - 200, 150);
+		ofDrawBitmapString(pool.nReused, ofGetScreenWidth() - 100, 150);
+		ofDrawBitmapString("pool peak = ", ofGetScreenWidth() - 200, 175);
+		ofDrawBitmapString(pool.peak, ofGetScreenWidth() - 100, 175);
+		ofDrawBitmapString("pool full = ", ofGetScreenWidth() - 200, 200);
+		ofDrawBitmapString(pool.nExhausted, ofGetScreenWidth() - 100, 200);
+	}
+
+	else if (gameState == loading) {
+		float w = 300;
+		float x = ofGetScreenWidth() / 2 - w / 2;
+		float y = ofGetScreenHeight() / 2;
+		ofDrawBitmapString("Loading", x, y - 15);
+		ofNoFill();
+		ofDrawRectangle(x, y, w, 20);
+		ofFill();
+		ofDrawRectangle(x, y, w * loader.progress(), 20);
+		ofSetBackgroundColor(ofColor::black);
 	}
-
 	else if (gameState == ready) {
 		ofDrawBitmapString("To start game press space bar", ofGetScreenWidth() / 2 -100, ofGetScreenHeight() / 2);
 		ofDrawBitmapString("1 = easy    2 = normal    3 = hard", ofGetScreenWidth() / 2 - 100, ofGetScreenHeight() / 2 + 25);
@@ -436,6 +287,10 @@ void ofApp::draw() {
 		else {
 			ofDrawBitmapString("False", ofGetScreenWidth() / 2 + 50, ofGetScreenHeight() / 2 + 125);
 		}
+		ofDrawBitmapString("Press 'r' to record the game = ", ofGetScreenWidth() / 2 - 100, ofGetScreenHeight() / 2 + 150);
+		ofDrawBitmapString(bRecord ? "True" : "False", ofGetScreenWidth() / 2 + 150, ofGetScreenHeight() / 2 + 150);
+		string waveState = world.waves ? "True" : "False";
+		ofDrawBitmapString("Press 'v' to spawn from " + waveFile + " = " + waveState, ofGetScreenWidth() / 2 - 100, ofGetScreenHeight() / 2 + 175);
 		ofSetBackgroundColor(ofColor::black);
 	}
 	else if (gameState == gameOver) {
@@ -448,6 +303,41 @@ void ofApp::draw() {
 	if (!bHide) {
 		gui.draw();
 	}
+	if (bProfile) {
+		drawProfile();
+	}
+}
+
+//--------------------------------------------------------------
+//Logs the game that is starting to bin/data/replay_<time>.bin, play it
+//back with "--replay"
+void ofApp::startRecording() {
+	string enemyPath = world.enemyEmitter->haveChildImage ? images.pathOf(world.enemyEmitter->childImage) : "";
+	string beamPath = world.beamEmitter->haveChildImage ? images.pathOf(world.beamEmitter->childImage) : "";
+	string path = ofToDataPath("replay_" + ofGetTimestampString() + ".bin");
+	if (recorder.start(path, world, enemyPath, beamPath)) {
+		cout << "recording " << path << endl;
+	}
+	else {
+		cout << "Can't write replay file " << path << endl;
+	}
+}
+
+//--------------------------------------------------------------
+//Draws min/avg/p99 (ms) of each profiler zone over the last 120 frames
+void ofApp::drawProfile() {
+	profiler().stats(zoneStats);
+	int y = ofGetScreenHeight() - 25 * (zoneStats.size() + 1);
+	ofSetColor(ofColor::white);
+	ofDrawBitmapString("zone                          min      avg      p99  (ms)", 10, y);
+	for (int i = 0; i < zoneStats.size(); i++) {
+		ZoneStats &z = zoneStats[i];
+		y += 25;
+		ofDrawBitmapString(z.name, 10, y);
+		ofDrawBitmapString(ofToString(z.min / 1000, 3), 250, y);
+		ofDrawBitmapString(ofToString(z.avg / 1000, 3), 322, y);
+		ofDrawBitmapString(ofToString(z.p99 / 1000, 3), 394, y);
+	}
 }
 
 //--------------------------------------------------------------
@@ -456,18 +346,21 @@ void ofApp::mouseMoved(int x, int y ){
 
 //--------------------------------------------------------------
 void ofApp::mouseDragged(int x, int y, int button){
-	if (bDrag) {
+	if (bDrag && gameState != loading && !recorder.isRecording()) {
 		glm::vec3 p = glm::vec3(x, y, 0);
 		glm::vec3 delta = p - lastMousePos;
-		player->pos += delta;
+		world.player->pos += delta;
+		world.player->savePrevious();   // draw where it was dragged, not blended
 		lastMousePos = p;
 	}
 }
 
 //--------------------------------------------------------------
+//Dragging moves the player outside the world's recorded inputs, so it is
+//off while a game is recorded, otherwise the replay would differ
 void ofApp::mousePressed(int x, int y, int button){
 	glm::vec3 pos = glm::vec3(x, y, 0);
-	if (player->insidePoint(pos)) {
+	if (gameState != loading && !recorder.isRecording() && world.player->insidePoint(pos)) {
 		bDrag = true;
 		lastMousePos = pos;
 	}
@@ -489,6 +382,8 @@ void ofApp::mouseExited(int x, int y){
 	
 //--------------------------------------------------------------
 void ofApp::keyPressed(int key) {
+	//The world isn't set up until the assets are loaded
+	if (gameState == loading) return;
 	switch (key) {
 		//Toggles Fullscreen
 	case 'f':
@@ -498,6 +393,35 @@ void ofApp::keyPressed(int key) {
 	case 'h':
 		bHide = !bHide;
 		break;
+		//Toggles batched sprite drawing
+	case 'b':
+		bBatchDraw = !bBatchDraw;
+		world.enemyEmitter->sys->bBatch = bBatchDraw;
+		world.beamEmitter->sys->bBatch = bBatchDraw;
+		break;
+		//Toggles recording the next game
+	case 'r':
+		if (gameState == ready) {
+			bRecord = !bRecord;
+		}
+		break;
+		//Toggles spawning from the wave file or the sliders
+	case 'v':
+		if (gameState == ready) {
+			bWaves = !bWaves;
+			setupObjects();
+		}
+		break;
+		//Toggles the profiler overlay
+	case 'p':
+		bProfile = !bProfile;
+		break;
+		//Writes the profiler zones as a Chrome trace
+	case 't':
+		if (profiler().writeTrace(ofToDataPath("trace.json"))) {
+			cout << "wrote " << ofToDataPath("trace.json") << endl;
+		}
+		break;
 		//Sets difficulty to easy
 	case '1':
 		if (gameState == ready) {
@@ -530,13 +454,13 @@ void ofApp::keyPressed(int key) {
 		}
 		else if (gameState == ready) {
 			gameState = playable;
+			if (bRecord) startRecording();
 			ofResetElapsedTimeCounter();
 			bHide = false;
 			break;
 		}
 		else if (gameState == playable) {
-			beamEmitter->spawnSprite();
-			beamEmitter->bBeam = true;
+			world.fire();
 			break;
 		}
 		//Toggles sprites at the beginning
@@ -553,22 +477,23 @@ void ofApp::keyPressed(int key) {
 
 //--------------------------------------------------------------
 void ofApp::keyReleased(int key) {
+	if (gameState == loading) return;
 	switch (key) {
 	case OF_KEY_LEFT:   // turn left
-		player->bEngine = false;
+		world.player->bEngine = false;
 		break;
 	case OF_KEY_RIGHT:  // turn right
-		player->bEngine = false;		
+		world.player->bEngine = false;		
 		break;
 	case OF_KEY_UP:     // go forward
-		player->bEngine = false;		
+		world.player->bEngine = false;		
 		break;
 	case OF_KEY_DOWN:   // go backward
-		player->bEngine = false;
+		world.player->bEngine = false;
 		break;
 	case ' ':
 		if (gameState == playable) {
-			beamEmitter->bBeam = false;
+			world.beamEmitter->bBeam = false;
 		}
 	default:
 		break;
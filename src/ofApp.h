@@ -2,30 +2,19 @@
 
 #include "ofMain.h"
 #include "ofxGui.h"
-#include "Emitter.h"
-#include "Shape.h"
-#include "Sprite.h"
+#include "World.h"
+#include "ImageRegistry.h"
+#include "Replay.h"
+#include "AudioSystem.h"
+#include "AssetLoader.h"
 
 
 
-class Agent : public Sprite {
-public:
-	Agent() {
-		Sprite::Sprite();
-//		cout << "in Agent Constuctor" << endl;
-	}
-};
-
-class AgentEmitter : public Emitter {
-public:
-	void spawnSprite();
-	void moveSprite(Sprite*);
-};
-
 enum gameState {
 	ready,
 	playable,
-	gameOver
+	gameOver,
+	loading
 };
 enum difficulty {
 	easy = 8,
@@ -43,12 +32,19 @@ class ofApp : public ofBaseApp{
 		void setupObjects();
 		void setupGui(enum difficulty);
 		void setupVisuals();
-
-		void updateKeyPressed();
-		void updatePlayer();
-		void updateEnemyEmitter();
-		void updateBeamEmitter();
-		void updateExplosionEmitter();
+		void startLoading();
+
+		void updateSettings();
+		template <class T>
+		void onSliderChanged(T &value) { bSlidersChanged = true; }
+		template <class T, class S>
+		void listenToSlider(S &slider) {
+			slider.removeListener(this, &ofApp::onSliderChanged<T>);
+			slider.addListener(this, &ofApp::onSliderChanged<T>);
+		}
+		void updateSounds();
+		void drawProfile();
+		void startRecording();
 
 		void keyPressed(int key);
 		void keyReleased(int key);
@@ -62,28 +58,27 @@ class ofApp : public ofBaseApp{
 		void dragEvent(ofDragInfo dragInfo);
 		void gotMessage(ofMessage msg);
 
-		bool checkCollision(Sprite s1, Sprite s2);
-		void checkBorder(Sprite &s);
-
-		Emitter *enemyEmitter = NULL;
-		Emitter *beamEmitter = NULL;
-		Sprite *player = NULL;
-		Emitter *explosionEmitter = NULL;
+		World world;
+		StepClock clock;
+		float renderAlpha = 1.0;
 		bool fire;
 
 		int totalTime;
 
-		ofImage enemyImage;
-		ofImage beamImage;
-		ofImage background;
+		ImageRegistry images;
+		ofImage *enemyImage = NULL;
+		ofImage *beamImage = NULL;
+		ofImage *background = NULL;
 
-		ofSoundPlayer beamSound;
-		ofSoundPlayer engineSound;
-		ofSoundPlayer explosionSound;
+		AssetLoader loader;
+		AudioSystem audio;
+		bool bSoundsLoaded = false;
+		bool bEngineSound = false;  // what the game has asked the audio to play
+		bool bBeamSound = false;
+		int explosionsHeard = 0;    // world.nExplosions already played
 
 		float beamTime = 0;
 		float beamInterval = 1000;
-		float explosionTime = 0;
 
 		bool enemyLoaded;
 		bool beamLoaded;
@@ -98,6 +93,16 @@ class ofApp : public ofBaseApp{
 		// Some basic UI
 		//
 		bool bHide;
+		bool bBatchDraw = true;
+		bool bProfile = false;
+		bool bRecord = false;       // record the next game to a replay log
+		WaveSchedule waves;
+		string waveFile = "waves/waves.txt";
+		bool bWaves = true;         // spawn from waves instead of the sliders
+		ReplayRecorder recorder;
+		vector<ZoneStats> zoneStats;
+
+		bool bSlidersChanged = true;    // copy the sliders to the world next update
 
 		//Enemy sliders
 		ofxFloatSlider rateOfSpawn;